@@ -6,10 +6,20 @@ layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
 layout(push_constant) uniform Push {
-  mat4 modelMatrix;
   mat4 lightProjectionView;
 } push;
 
+// shared with simple_shader.vert, only the model matrix is used here
+struct InstanceData {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+  vec2 uvScale;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer {
+  InstanceData instances[];
+} instanceBuffer;
+
 void main() {
-  gl_Position = push.lightProjectionView * push.modelMatrix * vec4(position, 1.0);
+  gl_Position = push.lightProjectionView * instanceBuffer.instances[gl_InstanceIndex].modelMatrix * vec4(position, 1.0);
 }
@@ -26,11 +26,6 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 layout(set = 1, binding = 0) uniform sampler2D texSampler;
 layout(set = 2, binding = 0) uniform sampler2DShadow shadowMap;
 
-layout(push_constant) uniform Push {
-  mat4 modelMatrix;
-  mat4 normalMatrix;
-} push;
-
 /**
  * @brief Calculates shadow factor with a small bias to prevent acne.
  */
@@ -26,20 +26,25 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
+struct InstanceData {
   mat4 modelMatrix;
   mat4 normalMatrix;
   vec2 uvScale;
-} push;
+};
+
+layout(std430, set = 3, binding = 1) readonly buffer InstanceBuffer {
+  InstanceData instances[];
+} instanceBuffer;
 
 void main() {
-  vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+  InstanceData object = instanceBuffer.instances[gl_InstanceIndex];
+  vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
   gl_Position = ubo.projection * ubo.view * positionWorld;
   
-  fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+  fragNormalWorld = normalize(mat3(object.normalMatrix) * normal);
   fragPosWorld = positionWorld.xyz;
   fragColor = color;
-  fragUV = uv * push.uvScale;
+  fragUV = uv * object.uvScale;
   
   // Convert to light space
   fragPosLight = ubo.lightProjectionView * positionWorld;
@@ -2,9 +2,12 @@
 
 // lve
 #include "core/lve_window.hpp"
+#include "core/lve_profiler.hpp"
 #include "core/lve_utils.hpp"
 #include "input/keyboard_movement_controller.hpp"
 #include "renderer/lve_buffer.hpp"
+#include "renderer/lve_gltf_model.hpp"
+#include "renderer/lve_instance_data.hpp"
 #include "renderer/lve_texture.hpp"
 #include "systems/point_light_system.hpp"
 #include "systems/simple_render_system.hpp"
@@ -23,6 +26,8 @@
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <cstdlib>
+#include <iterator>
 #include <stdexcept>
 #include <numeric>
 #include <algorithm>
@@ -43,8 +48,18 @@ namespace lve {
  * with its initial set of entities.
  */
 FirstApp::FirstApp() {
+  // per deployment presentation policy, e.g. VLM_PRESENT_MODE=fifo VLM_TARGET_FPS=30 on kiosks
+  if (const char* mode = std::getenv("VLM_PRESENT_MODE")) {
+    VkPresentModeKHR presentMode;
+    if (LveSwapChain::parsePresentMode(mode, presentMode)) lveRenderer.setPresentMode(presentMode);
+    else std::cerr << "unknown VLM_PRESENT_MODE " << mode << ", expected fifo, fifo_relaxed, mailbox or immediate" << std::endl;
+  }
+  if (const char* fps = std::getenv("VLM_TARGET_FPS")) frameLimiter.setTargetFps(std::strtof(fps, nullptr));
+
   initGlobalDescriptorPool();
+  geometryPool = std::make_unique<LveGeometryPool>(lveDevice, static_cast<uint32_t>(sizeof(LveModel::Vertex)));
   loadGameObjects();
+  lveDevice.allocator().printStats();
 }
 
 /**
@@ -63,8 +78,8 @@ FirstApp::~FirstApp() { saveTransforms(); }
  */
 void FirstApp::initGlobalDescriptorPool() {
   globalPool = LveDescriptorPool::Builder(lveDevice)
-                   .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT + 100)
-                   .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+                   .setMaxSets(LveRenderer::MAX_FRAMES_IN_FLIGHT + 100)
+                   .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveRenderer::MAX_FRAMES_IN_FLIGHT)
                    .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100)
                    .build();
 }
@@ -76,30 +91,34 @@ void FirstApp::initGlobalDescriptorPool() {
  * handles the lifecycle of various rendering subsystems.
  */
 void FirstApp::run() {
-  // initialize uniform buffers for per-frame global data
-  uboBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-  for (int i = 0; i < uboBuffers.size(); i++) {
-    uboBuffers[i] = std::make_unique<LveBuffer>(
-        lveDevice,
-        sizeof(GlobalUbo),
-        1,
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-    uboBuffers[i]->map();
-  }
-
   // create descriptor set layout for camera matrices and global lighting
   globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
                         .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
                         .build();
 
-  // allocating descriptor sets for each frame in flight
-  globalDescriptorSets.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-  for (int i = 0; i < globalDescriptorSets.size(); i++) {
-    auto bufferInfo = uboBuffers[i]->descriptorInfo();
+  // per-frame global data lives in the renderer's frame contexts, one for every possible frame in flight
+  for (auto& frame : lveRenderer.getFrameContexts()) {
+    frame.uboBuffer = std::make_unique<LveBuffer>(
+        lveDevice,
+        sizeof(GlobalUbo),
+        1,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        lveDevice.dynamicMemoryProperties(),
+        1,
+        LveMemoryTag::Uniform);
+    frame.uboBuffer->map();
+
+    auto bufferInfo = frame.uboBuffer->descriptorInfo();
     LveDescriptorWriter(*globalSetLayout, *globalPool)
         .writeBuffer(0, &bufferInfo)
-        .build(globalDescriptorSets[i]);
+        .build(frame.globalDescriptorSet);
+  }
+
+  // transient per-draw data, rewound every frame
+  frameAllocator = std::make_unique<LveFrameAllocator>(lveDevice, LveRenderer::MAX_FRAMES_IN_FLIGHT);
+  if (lveDevice.hasIndirectCount()) {
+    gpuCuller = std::make_unique<LveGpuCuller>(lveDevice, LveRenderer::MAX_FRAMES_IN_FLIGHT);
+    gpuCulling = true;
   }
 
   // initialize rendering subsystems
@@ -107,16 +126,17 @@ void FirstApp::run() {
   vlmUi = std::make_unique<VlmUi>(lveDevice, lveRenderer.getSwapChainRenderPass(), extent.width, extent.height);
   
   simpleRenderSystem = std::make_unique<SimpleRenderSystem>(
-      lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+      lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), frameAllocator->getSetLayout());
   
   pointLightSystem = std::make_unique<PointLightSystem>(
       lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
   
   shadowMap = std::make_unique<LveShadowMap>(lveDevice, 2048, 2048);
-  shadowSystem = std::make_unique<ShadowSystem>(lveDevice, lveRenderer.getShadowRenderPass());
+  shadowSystem = std::make_unique<ShadowSystem>(lveDevice, lveRenderer.getShadowRenderPass(), frameAllocator->getSetLayout());
   
   im3dSystem = std::make_unique<Im3dSystem>(
       lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+  for (auto& frame : lveRenderer.getFrameContexts()) im3dSystem->createFrameResources(frame);
 
   // setup shadow map descriptor for the main pass
   {
@@ -129,28 +149,28 @@ void FirstApp::run() {
         .build(shadowDescriptorSet);
   }
 
-  // bind textures for all game objects in the scene
-  for (auto& kv : gameObjects) {
-    auto& obj = kv.second;
-    if (obj.diffuseMap) {
-      VkDescriptorImageInfo imageInfo{};
-      imageInfo.sampler = obj.diffuseMap->getSampler();
-      imageInfo.imageView = obj.diffuseMap->getImageView();
-      imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-      LveDescriptorWriter(simpleRenderSystem->getTextureSetLayout(), *globalPool)
-          .writeImage(0, &imageInfo)
-          .build(obj.textureDescriptorSet);
-    }
-  }
+  // bind textures for all materials in the scene
+  scene.each<MaterialComponent>([&](LveEntity, MaterialComponent& material) {
+    if (!material.diffuseMap) return;
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = material.diffuseMap->getSampler();
+    imageInfo.imageView = material.diffuseMap->getImageView();
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    LveDescriptorWriter(simpleRenderSystem->getTextureSetLayout(), *globalPool)
+        .writeImage(0, &imageInfo)
+        .build(material.textureDescriptorSet);
+  });
 
   LveCamera camera{};
-  auto viewerObject = LveGameObject::createGameObject();
-  viewerObject.transform.translation.z = -2.5f;
+  TransformComponent viewerTransform{};
+  viewerTransform.setTranslation({0.f, 0.f, -2.5f});
   KeyboardMovementController cameraController{};
 
   auto currentTime = std::chrono::high_resolution_clock::now();
   float perfTimer = 0.0f;
   int frameCount = 0;
+  bool memoryWarned = false;
+  LVE_PROFILE_THREAD("main");
 
   /**
    * main execution loop
@@ -159,27 +179,48 @@ void FirstApp::run() {
    * coordinating the graphics pipeline.
    */
   while (!lveWindow.shouldClose()) {
-    glfwPollEvents();
+    LVE_PROFILE_FRAME();
+    frameLimiter.wait();
+    {
+      LVE_PROFILE_SCOPE("poll events");
+      glfwPollEvents();
+    }
 
     auto newTime = std::chrono::high_resolution_clock::now();
     float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
     currentTime = newTime;
     frameTime = std::min(frameTime, 0.1f);
 
-    processInput(frameTime, viewerObject, cameraController);
+    {
+      LVE_PROFILE_SCOPE("input");
+      processInput(frameTime, viewerTransform, cameraController);
+    }
 
     // update user interface state
-    vlmUi->update();
+    {
+      LVE_PROFILE_SCOPE("ui update");
+      vlmUi->update();
+    }
     
     // transform camera relative to viewer object
-    camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+    camera.setViewYXZ(viewerTransform.getTranslation(), viewerTransform.getRotation());
     auto viewerPos = camera.getPosition();
 
     // calculate telemetry data for the ui hud
     perfTimer += frameTime;
     frameCount++;
     if (perfTimer >= 0.2f) {
-      vlmUi->updateTelemetry(frameCount / perfTimer, viewerPos.x, viewerPos.y, viewerPos.z);
+      LVE_PROFILE_SCOPE("telemetry");
+      auto budgets = lveDevice.queryMemoryBudget();
+      bool nearBudget = std::any_of(budgets.begin(), budgets.end(), [](const auto &heap) { return heap.isNearBudget(); });
+      if (nearBudget && !memoryWarned) {
+        std::cerr << "warning: gpu memory usage is above " << static_cast<int>(LveHeapBudget::WARNING_RATIO * 100.f) << "% of the heap budget" << std::endl;
+        lveDevice.allocator().printStats();
+      }
+      memoryWarned = nearBudget;
+      vlmUi->updateTelemetry(frameCount / perfTimer, viewerPos.x, viewerPos.y, viewerPos.z, budgets, lveDevice.allocator().getTagStats());
+      vlmUi->updateGpuTimings(lveRenderer.gpuProfiler().getResults());
+      vlmUi->updateRenderStats(lveRenderer.renderStats().getLastFrame(), lveRenderer.renderStats().getPassResults(), cullStats, shadowCullStats);
       perfTimer = 0.f;
       frameCount = 0;
     }
@@ -201,6 +242,7 @@ void FirstApp::run() {
      * edit mode.
      */
     {
+      LVE_PROFILE_SCOPE("im3d");
       auto currentExtent = lveRenderer.getSwapChainExtent();
       auto& ad = Im3d::GetAppData();
       ad.m_deltaTime = frameTime;
@@ -225,30 +267,32 @@ void FirstApp::run() {
       Im3d::NewFrame();
       if (editMode) {
         // draw bounding boxes for all visible models
-        for (auto& kv : gameObjects) {
-          auto& obj = kv.second;
-          if (!obj.model) continue;
-          bool isSelected = (obj.getId() == selectedObjectId);
+        scene.each<MeshComponent, TransformComponent>([&](LveEntity entity, const MeshComponent& mesh, const TransformComponent& transform) {
+          bool isSelected = (entity == selectedEntity);
           Im3d::PushColor(isSelected ? Im3d::Color_Cyan : Im3d::Color_Yellow);
           Im3d::PushSize(isSelected ? 2.f : 1.f);
-          Im3d::PushMatrix(Im3dSystem::toIm3d(obj.transform.mat4()));
-          const auto& b = obj.model->getBoundingBox();
+          Im3d::PushMatrix(Im3dSystem::toIm3d(transform.mat4()));
+          const auto& b = mesh.model->getBoundingBox();
           Im3d::DrawAlignedBox({b.min.x, b.min.y, b.min.z}, {b.max.x, b.max.y, b.max.z});
           Im3d::PopMatrix();
           Im3d::PopSize();
           Im3d::PopColor();
-        }
+        });
         // handle gizmo interaction for selected objects
-        if (selectedObjectId != std::numeric_limits<LveGameObject::id_t>::max()) {
-          auto it = gameObjects.find(selectedObjectId);
-          if (it != gameObjects.end()) {
-            float p[3] = {it->second.transform.translation.x, it->second.transform.translation.y, it->second.transform.translation.z};
-            if (Im3d::GizmoTranslation("gizmo", p)) {
-              it->second.transform.translation = {p[0], p[1], p[2]};
-            }
+        if (auto* transform = scene.tryGet<TransformComponent>(selectedEntity)) {
+          const auto& t = transform->getTranslation();
+          float p[3] = {t.x, t.y, t.z};
+          if (Im3d::GizmoTranslation("gizmo", p)) {
+            transform->setTranslation({p[0], p[1], p[2]});
           }
         }
+        // clicks on the gizmo drag it, anywhere else they select the mesh surface under the cursor
+        if (pickRequested && Im3d::GetHotId() == Im3d::Id_Invalid) {
+          LVE_PROFILE_SCOPE("pick");
+          selectedEntity = scene.raycast(viewerPos, rw, PICK_DISTANCE).entity;
+        }
       }
+      pickRequested = false;
       Im3d::EndFrame();
     }
 
@@ -260,7 +304,11 @@ void FirstApp::run() {
      */
     if (auto commandBuffer = lveRenderer.beginFrame()) {
       int frameIndex = lveRenderer.getFrameIndex();
-      FrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex], gameObjects};
+      auto& frameContext = lveRenderer.getCurrentFrameContext();
+      geometryPool->beginFrame(lveRenderer.getFrameNumber(), lveRenderer.getCompletedFrameNumber());
+      frameAllocator->beginFrame(frameIndex);
+      FrameInfo frameInfo{
+          frameIndex, frameTime, commandBuffer, camera, frameContext.globalDescriptorSet, scene, *frameAllocator, lveRenderer, frameContext};
 
       // configuring shadow mapping light space matrices
       glm::mat4 lightProjection = glm::ortho(-20.f, 20.f, -20.f, 20.f, 0.1f, 150.f);
@@ -268,6 +316,7 @@ void FirstApp::run() {
       glm::mat4 lightProjectionView = lightProjection * lightView;
 
       // updating global uniform buffer object
+      LVE_PROFILE_SCOPE("render");
       GlobalUbo ubo{};
       ubo.projection = camera.getProjection();
       ubo.view = camera.getView();
@@ -275,23 +324,109 @@ void FirstApp::run() {
       ubo.lightProjectionView = lightProjectionView;
       ubo.ambientLightColor = glm::vec4(1.f, 1.f, 1.f, .05f);
 
-      pointLightSystem->update(frameInfo, ubo);
-      uboBuffers[frameIndex]->writeToBuffer(&ubo);
-      uboBuffers[frameIndex]->flush();
+      pointLightSystem->animate(frameInfo);
+
+      // the only place matrices are rebuilt, every pass below reads the cached ones
+      {
+        LVE_PROFILE_SCOPE("transform update");
+        LVE_PROFILE_COUNTER("transforms updated", scene.updateTransforms(&lveRenderer.workerPool()));
+        LVE_PROFILE_COUNTER("bvh reinserts", scene.updateBounds());
+      }
+
+      {
+        LVE_PROFILE_SCOPE("ubo update");
+        pointLightSystem->update(frameInfo, ubo);
+        frameContext.uboBuffer->writeToBuffer(&ubo);
+        frameContext.uboBuffer->flush();
+      }
+
+      if (gpuCulling) {
+        // only changed objects are written, the visibility test and draw lists are built by the gpu.
+        // casters are bounded by the whole camera frustum rather than the visible meshes, and the
+        // stats are a few frames old
+        LVE_PROFILE_SCOPE("gpu culling");
+        gpuCuller->update(scene, frameIndex, lveRenderer.getSwapChainExtent());
+        {
+          LveGpuProfiler::Scope scope{lveRenderer.gpuProfiler(), commandBuffer, "gpu culling"};
+          const glm::mat4 cameraProjectionView = camera.getProjection() * camera.getView();
+          gpuCuller->cull(commandBuffer, LveFrustum::fromMatrix(cameraProjectionView), LveFrustum::fromMatrix(lightProjectionView), cameraProjectionView, lightView);
+        }
+        cullStats = gpuCuller->getStats(LveGpuCuller::CAMERA);
+        shadowCullStats = gpuCuller->getStats(LveGpuCuller::SHADOW);
+      } else {
+        {
+          LVE_PROFILE_SCOPE("frustum culling");
+          frustumCuller.updateBounds(scene);
+          cullStats = frustumCuller.cull(LveFrustum::fromMatrix(camera.getProjection() * camera.getView()), visibleMeshes);
+          LVE_PROFILE_COUNTER("visible meshes", cullStats.visible);
+          LVE_PROFILE_COUNTER("culled meshes", cullStats.culled);
+        }
+
+        // casters outside the light volume, or whose shadow cannot land on anything visible, are skipped
+        {
+          LVE_PROFILE_SCOPE("shadow caster culling");
+          shadowCullStats = frustumCuller.cullShadowCasters(LveFrustum::fromMatrix(lightProjectionView), lightView, visibleMeshes, shadowCasters);
+          LVE_PROFILE_COUNTER("shadow casters", shadowCullStats.visible);
+          LVE_PROFILE_COUNTER("rejected casters", shadowCullStats.culled);
+        }
+
+        // every visible mesh and caster takes at most one instance, and every run at most one aligned slice
+        const size_t instanceCount = visibleMeshes.size() + shadowCasters.size();
+        frameAllocator->reserve(instanceCount * sizeof(LveInstanceData), static_cast<uint32_t>(instanceCount));
+      }
 
       //shadow map generation pass
-      lveRenderer.beginShadowRenderPass(commandBuffer, shadowMap);
-      shadowSystem->renderShadowMap(frameInfo, lightProjectionView);
-      lveRenderer.endShadowRenderPass(commandBuffer);
-
-      // high quality forward pass with ui and debug overlays
-      lveRenderer.beginSwapChainRenderPass(commandBuffer);
-      simpleRenderSystem->renderGameObjects(frameInfo, shadowDescriptorSet);
-      pointLightSystem->render(frameInfo);
-      im3dSystem->render(frameInfo);
-      vlmUi->render(commandBuffer);
+      {
+        LVE_PROFILE_SCOPE("shadow pass");
+        lveRenderer.beginShadowRenderPass(commandBuffer, shadowMap);
+        if (gpuCulling) shadowSystem->renderShadowMapIndirect(frameInfo, lightProjectionView, *gpuCuller);
+        else shadowSystem->renderShadowMap(frameInfo, lightProjectionView, shadowCasters);
+        lveRenderer.endShadowRenderPass(commandBuffer);
+      }
+
+      // high quality forward pass with ui and debug overlays. with occlusion the gpu path splits it around
+      // the depth pyramid: what was visible last frame is drawn first, the late half adds what its depth revealed
+      if (gpuCulling && gpuCuller->getOcclusion()) {
+        LVE_PROFILE_SCOPE("forward pass");
+        lveRenderer.beginSwapChainRenderPass(commandBuffer, LveSwapChain::Pass::Early);
+        simpleRenderSystem->renderIndirect(frameInfo, shadowDescriptorSet, *gpuCuller, LveGpuCuller::CAMERA);
+        lveRenderer.endSwapChainRenderPass(commandBuffer);
+        {
+          LveGpuProfiler::Scope scope{lveRenderer.gpuProfiler(), commandBuffer, "occlusion culling"};
+          gpuCuller->cullLate(commandBuffer, lveRenderer.getDepthImageView());
+        }
+        lveRenderer.beginSwapChainRenderPass(commandBuffer, LveSwapChain::Pass::Late);
+        simpleRenderSystem->renderIndirect(frameInfo, shadowDescriptorSet, *gpuCuller, LveGpuCuller::CAMERA_LATE);
+      } else {
+        LVE_PROFILE_SCOPE("forward pass");
+        lveRenderer.beginSwapChainRenderPass(commandBuffer);
+        if (gpuCulling) simpleRenderSystem->renderIndirect(frameInfo, shadowDescriptorSet, *gpuCuller, LveGpuCuller::CAMERA);
+        else simpleRenderSystem->renderGameObjects(frameInfo, shadowDescriptorSet, visibleMeshes);
+      }
+
+      // the overlays are cheap, they share one secondary recorded on this thread
+      LVE_PROFILE_SCOPE("overlays");
+      auto overlayCommandBuffer = lveRenderer.beginSecondaryCommandBuffer();
+      frameInfo.commandBuffer = overlayCommandBuffer;
+      auto& gpuProfiler = lveRenderer.gpuProfiler();
+      {
+        LveGpuProfiler::Scope scope{gpuProfiler, overlayCommandBuffer, "point lights"};
+        pointLightSystem->render(frameInfo);
+      }
+      {
+        LveGpuProfiler::Scope scope{gpuProfiler, overlayCommandBuffer, "im3d"};
+        im3dSystem->render(frameInfo);
+      }
+      {
+        LveGpuProfiler::Scope scope{gpuProfiler, overlayCommandBuffer, "ui composite"};
+        vlmUi->render(overlayCommandBuffer);
+      }
+      lveRenderer.executeSecondaryCommandBuffers(commandBuffer, 1, &overlayCommandBuffer);
+      frameInfo.commandBuffer = commandBuffer;
       
       lveRenderer.endSwapChainRenderPass(commandBuffer);
+      LVE_PROFILE_COUNTER("frame allocator bytes", frameAllocator->getUsedBytes());
+      LVE_PROFILE_COUNTER("entities", scene.getEntityCount());
       lveRenderer.endFrame();
     }
   }
@@ -303,12 +438,20 @@ void FirstApp::run() {
 /**
  * handles per-frame polling for engine state and mode toggles.
  * 
- * processes f1/f3 hotkeys for menu and editor modes, handles mouse raycasting
- * for object selection, and updates camera movement state.
+ * processes f1/f3 hotkeys for menu and editor modes, f5 for cpu trace capture, f6/f7/f8 to cycle
+ * frames in flight, present mode and frame cap, f9 to switch between cpu and gpu culling, f10 to toggle
+ * gpu occlusion culling, handles
+ * mouse raycasting for object selection, and updates camera movement state.
  */
-void FirstApp::processInput(float frameTime, LveGameObject& viewerObject, KeyboardMovementController& cameraController) {
+void FirstApp::processInput(float frameTime, TransformComponent& viewerTransform, KeyboardMovementController& cameraController) {
   static bool f1WasPressed = false;
   static bool f3WasPressed = false;
+  static bool f5WasPressed = false;
+  static bool f6WasPressed = false;
+  static bool f7WasPressed = false;
+  static bool f8WasPressed = false;
+  static bool f9WasPressed = false;
+  static bool f10WasPressed = false;
 
   // toggle dev menu with f1
   if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F1) == GLFW_PRESS) {
@@ -331,32 +474,97 @@ void FirstApp::processInput(float frameTime, LveGameObject& viewerObject, Keyboa
     f3WasPressed = true;
   } else f3WasPressed = false;
 
+  // f5 starts a cpu trace capture, the next press writes it out
+  if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F5) == GLFW_PRESS) {
+    if (!f5WasPressed) {
+      if (!LveProfiler::isEnabled()) {
+        LveProfiler::clear();
+        LveProfiler::setEnabled(true);
+        std::cout << "cpu trace capture started" << std::endl;
+      } else {
+        LveProfiler::setEnabled(false);
+        if (LveProfiler::exportChromeTrace(TRACE_PATH)) {
+          std::cout << "cpu trace written to " << TRACE_PATH << std::endl;
+        } else {
+          std::cerr << "failed to write cpu trace to " << TRACE_PATH << std::endl;
+        }
+      }
+    }
+    f5WasPressed = true;
+  } else f5WasPressed = false;
+
+  // f6 cycles frames in flight, 1 for latency through 3 for throughput
+  if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F6) == GLFW_PRESS) {
+    if (!f6WasPressed) {
+      lveRenderer.setFramesInFlight(lveRenderer.getFramesInFlight() % LveRenderer::MAX_FRAMES_IN_FLIGHT + 1);
+      std::cout << "frames in flight: " << lveRenderer.getFramesInFlight() << std::endl;
+    }
+    f6WasPressed = true;
+  } else f6WasPressed = false;
+
+  // f7 cycles the present mode, the swap chain is rebuilt on the next frame
+  if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F7) == GLFW_PRESS) {
+    if (!f7WasPressed) {
+      static constexpr VkPresentModeKHR modes[] = {
+          VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+      size_t current = std::find(std::begin(modes), std::end(modes), lveRenderer.getPresentMode()) - std::begin(modes);
+      auto next = modes[(current + 1) % std::size(modes)];
+      lveRenderer.setPresentMode(next);
+      std::cout << "present mode: " << LveSwapChain::presentModeName(next) << std::endl;
+    }
+    f7WasPressed = true;
+  } else f7WasPressed = false;
+
+  // f8 cycles the frame cap
+  if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F8) == GLFW_PRESS) {
+    if (!f8WasPressed) {
+      static constexpr float caps[] = {0.f, 30.f, 60.f, 120.f};
+      size_t current = std::find(std::begin(caps), std::end(caps), frameLimiter.getTargetFps()) - std::begin(caps);
+      frameLimiter.setTargetFps(caps[(current + 1) % std::size(caps)]);
+      if (frameLimiter.isEnabled()) std::cout << "frame cap: " << frameLimiter.getTargetFps() << " fps" << std::endl;
+      else std::cout << "frame cap: off" << std::endl;
+    }
+    f8WasPressed = true;
+  } else f8WasPressed = false;
+
+  // f9 switches between cpu culling with sorted draws and gpu culling with indirect draws
+  if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F9) == GLFW_PRESS) {
+    if (!f9WasPressed) {
+      if (gpuCuller) {
+        gpuCulling = !gpuCulling;
+        std::cout << "culling: " << (gpuCulling ? "gpu" : "cpu") << std::endl;
+      } else {
+        std::cout << "gpu culling needs drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance" << std::endl;
+      }
+    }
+    f9WasPressed = true;
+  } else f9WasPressed = false;
+
+  // f10 toggles occlusion culling against the depth pyramid, the gpu path only
+  if (glfwGetKey(lveWindow.getGLFWwindow(), GLFW_KEY_F10) == GLFW_PRESS) {
+    if (!f10WasPressed && gpuCuller) {
+      gpuCuller->setOcclusion(!gpuCuller->getOcclusion());
+      std::cout << "occlusion culling: " << (gpuCuller->getOcclusion() ? "on" : "off") << std::endl;
+    }
+    f10WasPressed = true;
+  } else f10WasPressed = false;
+
   // handle mouse selection when in editor mode
   if (editMode && !menuOpen) {
     static bool mouseLeftWasPressed = false;
     bool currentMouseLeft = glfwGetMouseButton(lveWindow.getGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
     
-    if (currentMouseLeft && !mouseLeftWasPressed) {
-      double mx, my;
-      glfwGetCursorPos(lveWindow.getGLFWwindow(), &mx, &my);
-      
-      // performing raycast selection
-      float x = (2.f * static_cast<float>(mx)) / lveRenderer.getSwapChainExtent().width - 1.f;
-      float y = (2.f * static_cast<float>(my)) / lveRenderer.getSwapChainExtent().height - 1.f;
-      
-      glm::mat4 invProj = glm::inverse(viewerObject.transform.mat4()); // dummy usage, should use camera
-      // we'll use a direct ray calculation from current camera state
-      // (simplified version of the one used in Im3d block for consistency)
-    }
+    // resolved in the im3d block, where the cursor ray for this frame is built
+    if (currentMouseLeft && !mouseLeftWasPressed) pickRequested = true;
     mouseLeftWasPressed = currentMouseLeft;
   }
 
   // coordinate movement logic
   if (!menuOpen) {
-    cameraController.moveFree(lveWindow.getGLFWwindow(), frameTime, viewerObject);
+    cameraController.moveFree(lveWindow.getGLFWwindow(), frameTime, viewerTransform);
     double scrollDelta = lveWindow.getScrollOffsetAndReset();
     if (scrollDelta != 0.0) {
-      cameraController.handleScroll(lveWindow.getGLFWwindow(), scrollDelta, viewerObject);
+      cameraController.handleScroll(lveWindow.getGLFWwindow(), scrollDelta, viewerTransform);
     }
   } else {
     // forward raw input to ui when menu is active
@@ -374,12 +582,15 @@ void FirstApp::processInput(float frameTime, LveGameObject& viewerObject, Keyboa
 }
 
 /**
- * populates the runtime scene with a set of default game objects.
+ * populates the runtime scene with a set of default entities.
  * 
  * loads materials, meshes, and point lights, placing them in their
  * initial world space positions.
  */
 void FirstApp::loadGameObjects() {
+  // every mesh and texture below goes out in one streaming submission
+  LveUploadBatch uploads{lveDevice.streamingQueue()};
+
   auto stoneTexture = std::make_shared<LveTexture>(lveDevice, std::string(ENGINE_DIR) + "textures/stone.png");
   unsigned char whitePixel[] = {255, 255, 255, 255};
   auto defaultWhiteTexture = std::make_shared<LveTexture>(lveDevice, 1, 1, whitePixel);
@@ -387,15 +598,20 @@ void FirstApp::loadGameObjects() {
   auto instantiate = [&](const std::string& name, const std::string& meshPath, 
                         glm::vec3 pos, glm::vec3 scale, glm::vec3 rot, 
                         std::shared_ptr<LveTexture> tex, glm::vec2 uvScale) {
-    auto gameObject = LveGameObject::createGameObject();
-    gameObject.name = name;
-    gameObject.model = LveModel::createModelFromFile(lveDevice, meshPath);
-    gameObject.transform.translation = pos;
-    gameObject.transform.scale = scale;
-    gameObject.transform.rotation = rot;
-    gameObject.diffuseMap = tex ? tex : defaultWhiteTexture;
-    gameObject.uvScale = uvScale;
-    gameObjects.emplace(gameObject.getId(), std::move(gameObject));
+    auto entity = scene.createEntity(name);
+    auto& transform = scene.get<TransformComponent>(entity);
+    transform.setTranslation(pos);
+    transform.setScale(scale);
+    transform.setRotation(rot);
+    MaterialComponent material{tex ? tex : defaultWhiteTexture, VK_NULL_HANDLE, uvScale};
+    // gltf node hierarchies become child entities under this one, sharing its material
+    auto extension = meshPath.substr(meshPath.find_last_of('.') + 1);
+    if (extension == "gltf" || extension == "glb") {
+      LveGltfModel{lveDevice, std::string(ENGINE_DIR) + meshPath, geometryPool.get()}.instantiate(scene, entity, &material);
+      return;
+    }
+    scene.add<MeshComponent>(entity, {LveModel::createModelFromFile(lveDevice, meshPath, geometryPool.get())});
+    scene.add<MaterialComponent>(entity, material);
   };
 
   instantiate("Plate", "models/plate.obj", {0.f, .5f, 5.f}, {.002f, .002f, .002f}, {glm::pi<float>(), 0.f, 0.f}, nullptr, {1.f, 1.f});
@@ -407,42 +623,42 @@ void FirstApp::loadGameObjects() {
     {1.f, 1.f, .1f}, {.1f, 1.f, 1.f}, {1.f, 1.f, 1.f}
   };
   for (size_t i = 0; i < lightColors.size(); i++) {
-    auto light = LveGameObject::makePointLight(.5f, .1f, lightColors[i]);
-    light.name = "Light_" + std::to_string(i);
+    auto light = scene.createPointLight(.5f, .1f, lightColors[i], "Light_" + std::to_string(i));
     auto rotation = glm::rotate(glm::mat4(1.f), (i * glm::two_pi<float>()) / 6, {0.f, -1.f, 0.f});
-    light.transform.translation = glm::vec3(rotation * glm::vec4(-1.5f, -1.f, -1.5f, 1.f));
-    gameObjects.emplace(light.getId(), std::move(light));
+    scene.get<TransformComponent>(light).setTranslation(glm::vec3(rotation * glm::vec4(-1.5f, -1.f, -1.5f, 1.f)));
   }
 
   // add high intensity sun light for shadow logic
-  auto sun = LveGameObject::makePointLight(10000.f, 5.f, {.98f, 1.f, .95f});
-  sun.name = "Sun";
-  sun.transform.translation = {-30.f, -60.f, -30.f};
-  gameObjects.emplace(sun.getId(), std::move(sun));
+  auto sun = scene.createPointLight(10000.f, 5.f, {.98f, 1.f, .95f}, "Sun");
+  scene.get<TransformComponent>(sun).setTranslation({-30.f, -60.f, -30.f});
 
+  uploads.end();
   loadTransforms();
+  scene.updateTransforms();
 }
 
 /**
- * serializes current game object transformations to disk.
+ * serializes named entity transformations to disk.
  * 
  * allows for session persistence of object placement during development.
  */
 void FirstApp::saveTransforms() {
   std::ofstream out("scene_transforms.txt");
   if (!out.is_open()) return;
-  for (auto& kv : gameObjects) {
-    auto& obj = kv.second;
-    if (obj.name.empty()) continue;
-    out << obj.name << " " 
-        << obj.transform.translation.x << " " << obj.transform.translation.y << " " << obj.transform.translation.z << " "
-        << obj.transform.rotation.x << " " << obj.transform.rotation.y << " " << obj.transform.rotation.z << " "
-        << obj.transform.scale.x << " " << obj.transform.scale.y << " " << obj.transform.scale.z << "\n";
-  }
+  scene.each<NameComponent, TransformComponent>([&](LveEntity, const NameComponent& name, const TransformComponent& transform) {
+    if (name.name.empty()) return;
+    const auto& t = transform.getTranslation();
+    const auto& r = transform.getRotation();
+    const auto& s = transform.getScale();
+    out << name.name << " " 
+        << t.x << " " << t.y << " " << t.z << " "
+        << r.x << " " << r.y << " " << r.z << " "
+        << s.x << " " << s.y << " " << s.z << "\n";
+  });
 }
 
 /**
- * restores game object transformations from a persisted disk file.
+ * restores named entity transformations from a persisted disk file.
  */
 void FirstApp::loadTransforms() {
   std::ifstream in("scene_transforms.txt");
@@ -453,13 +669,10 @@ void FirstApp::loadTransforms() {
     std::string name;
     float tx, ty, tz, rx, ry, rz, sx, sy, sz;
     if (ss >> name >> tx >> ty >> tz >> rx >> ry >> rz >> sx >> sy >> sz) {
-      for (auto& kv : gameObjects) {
-        if (kv.second.name == name) {
-          kv.second.transform.translation = {tx, ty, tz};
-          kv.second.transform.rotation = {rx, ry, rz};
-          kv.second.transform.scale = {sx, sy, sz};
-          break;
-        }
+      if (auto* transform = scene.tryGet<TransformComponent>(scene.findByName(name))) {
+        transform->setTranslation({tx, ty, tz});
+        transform->setRotation({rx, ry, rz});
+        transform->setScale({sx, sy, sz});
       }
     }
   }
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "core/lve_device.hpp"
+#include "core/lve_frame_limiter.hpp"
 #include "renderer/lve_descriptors.hpp"
-#include "scene/lve_game_object.hpp"
+#include "renderer/lve_frame_allocator.hpp"
+#include "renderer/lve_geometry_pool.hpp"
+#include "renderer/lve_gpu_culling.hpp"
+#include "scene/lve_culling.hpp"
+#include "scene/lve_scene.hpp"
 #include "renderer/lve_renderer.hpp"
 #include "core/lve_window.hpp"
 #include "ui/vlm_ui.hpp"
@@ -26,6 +31,9 @@ class FirstApp {
  public:
   static constexpr int WIDTH = 1200;
   static constexpr int HEIGHT = 800;
+  static constexpr const char *TRACE_PATH = "vlm_trace.json";
+  // matches the camera far plane
+  static constexpr float PICK_DISTANCE = 100.f;
 
   /**
    * initializes the app, creating the device, window, and initial scene.
@@ -74,10 +82,10 @@ class FirstApp {
   /**
    * handles per-frame input polling and camera controller logic.
    * @param frameTime time delta since last frame.
-   * @param viewerObject camera proxy object.
+   * @param viewerTransform camera proxy transform.
    * @param cameraController input controller instance.
    */
-  void processInput(float frameTime, LveGameObject& viewerObject, class KeyboardMovementController& cameraController);
+  void processInput(float frameTime, TransformComponent& viewerTransform, class KeyboardMovementController& cameraController);
 
   /**
    * executes the primary rendering pipeline for a single frame.
@@ -89,14 +97,16 @@ class FirstApp {
   LveWindow lveWindow{WIDTH, HEIGHT, "vlm engine"};
   LveDevice lveDevice{lveWindow};
   LveRenderer lveRenderer{lveWindow, lveDevice};
+  LveFrameLimiter frameLimiter;
 
   // global resource management
   std::unique_ptr<LveDescriptorPool> globalPool{};
   std::unique_ptr<LveDescriptorSetLayout> globalSetLayout{};
-  std::vector<std::unique_ptr<LveBuffer>> uboBuffers;
-  std::vector<VkDescriptorSet> globalDescriptorSets;
+  std::unique_ptr<LveFrameAllocator> frameAllocator;
   
-  LveGameObject::Map gameObjects;
+  // shared mesh storage, declared before the scene whose models suballocate from it
+  std::unique_ptr<LveGeometryPool> geometryPool{};
+  LveScene scene;
   
   // high level subsystems
   std::unique_ptr<VlmUi> vlmUi;
@@ -111,13 +121,28 @@ class FirstApp {
   // descriptor sets
   VkDescriptorSet shadowDescriptorSet;
 
+  // camera and shadow caster culling, both lists hold mesh pool slots and are reused every frame
+  LveFrustumCuller frustumCuller;
+  std::vector<uint32_t> visibleMeshes;
+  std::vector<uint32_t> shadowCasters;
+  LveCullStats cullStats{};
+  LveCullStats shadowCullStats{};
+
+  // compute culling feeding indirect draws, only created when the device supports indirect count
+  std::unique_ptr<LveGpuCuller> gpuCuller;
+  /** toggled with f9, starts enabled whenever the gpu culler exists. */
+  bool gpuCulling = false;
+
   /** tracks whether the internal f1 dev menu is currently displayed. */
   bool menuOpen = false;
   
   /** tracks whether f3 edit mode is active for object selection and manipulation. */
   bool editMode = false;
   
-  /** id of the currently selected game object. */
-  LveGameObject::id_t selectedObjectId = std::numeric_limits<LveGameObject::id_t>::max();
+  /** handle of the currently selected entity, invalid when nothing is selected. */
+  LveEntity selectedEntity{};
+
+  /** set by a left click in edit mode, consumed once the cursor ray is known. */
+  bool pickRequested = false;
 };
 }  // namespace lve
@@ -0,0 +1,285 @@
+#include "core/lve_allocator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * allocator implementation.
+ * each block keeps an offset-sorted free list; allocation is best fit with alignment
+ * padding left in the list, and freeing coalesces with both neighbours.
+ */
+
+namespace lve {
+
+struct LveMemoryBlock {
+  struct Range {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize size = 0;
+  uint32_t memoryTypeIndex = 0;
+  LveAllocationKind kind = LveAllocationKind::Linear;
+  bool dedicated = false;
+  char *mapped = nullptr;
+
+  VkDeviceSize usedBytes = 0;
+  uint32_t allocationCount = 0;
+  std::vector<Range> freeRanges;
+};
+
+const char *memoryTagName(LveMemoryTag tag) noexcept {
+  switch (tag) {
+    case LveMemoryTag::Mesh:
+      return "mesh";
+    case LveMemoryTag::Texture:
+      return "texture";
+    case LveMemoryTag::ShadowMap:
+      return "shadow map";
+    case LveMemoryTag::Ui:
+      return "ui";
+    case LveMemoryTag::Staging:
+      return "staging";
+    case LveMemoryTag::Uniform:
+      return "uniform";
+    case LveMemoryTag::Attachment:
+      return "attachment";
+    default:
+      return "other";
+  }
+}
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) noexcept {
+  return value / alignment * alignment;
+}
+
+LveAllocator::LveAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, const VkPhysicalDeviceLimits &limits)
+    : device{device}, memoryProperties{memoryProperties}, nonCoherentAtomSize{std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1)} {}
+
+LveAllocator::~LveAllocator() {
+  for (auto &block : blocks) {
+    if (block->mapped) vkUnmapMemory(device, block->memory);
+    vkFreeMemory(device, block->memory, nullptr);
+  }
+}
+
+VkDeviceSize LveAllocator::blockSizeForType(uint32_t memoryTypeIndex) const noexcept {
+  VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+  // small heaps (bar windows, some integrated parts) would be eaten by a handful of 64mb blocks
+  return heapSize <= 1024ull * 1024 * 1024 ? alignUp(heapSize / 8, 1024 * 1024) : DEFAULT_BLOCK_SIZE;
+}
+
+LveMemoryBlock *LveAllocator::createBlock(uint32_t memoryTypeIndex, LveAllocationKind kind, VkDeviceSize size, bool dedicated) {
+  auto block = std::make_unique<LveMemoryBlock>();
+  block->size = size;
+  block->memoryTypeIndex = memoryTypeIndex;
+  block->kind = kind;
+  block->dedicated = dedicated;
+  block->freeRanges.push_back({0, size});
+
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryTypeIndex;
+  if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) throw std::runtime_error("failed to allocate device memory block");
+
+  // host visible blocks stay mapped for their whole lifetime since memory can only be mapped once
+  if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    void *data = nullptr;
+    if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+      vkFreeMemory(device, block->memory, nullptr);
+      throw std::runtime_error("failed to map device memory block");
+    }
+    block->mapped = static_cast<char *>(data);
+  }
+
+  blocks.push_back(std::move(block));
+  return blocks.back().get();
+}
+
+void LveAllocator::destroyBlock(LveMemoryBlock *block) {
+  if (block->mapped) vkUnmapMemory(device, block->memory);
+  vkFreeMemory(device, block->memory, nullptr);
+  blocks.erase(std::find_if(blocks.begin(), blocks.end(), [block](const auto &b) { return b.get() == block; }));
+}
+
+LveAllocation LveAllocator::allocate(const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, LveAllocationKind kind, LveMemoryTag tag) {
+  if (requirements.size == 0) throw std::invalid_argument("cannot allocate zero bytes of device memory");
+
+  VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+  VkDeviceSize size = requirements.size;
+  VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+  if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+    // keep flush/invalidate ranges of neighbouring allocations from overlapping
+    alignment = std::max(alignment, nonCoherentAtomSize);
+    size = alignUp(size, nonCoherentAtomSize);
+  }
+
+  std::lock_guard<std::mutex> lock{mutex};
+
+  LveMemoryBlock *target = nullptr;
+  size_t rangeIndex = 0;
+  VkDeviceSize blockSize = blockSizeForType(memoryTypeIndex);
+
+  if (size > blockSize / 2) {
+    target = createBlock(memoryTypeIndex, kind, size, true);
+  } else {
+    VkDeviceSize bestSize = std::numeric_limits<VkDeviceSize>::max();
+    for (auto &block : blocks) {
+      if (block->dedicated || block->memoryTypeIndex != memoryTypeIndex || block->kind != kind) continue;
+      for (size_t i = 0; i < block->freeRanges.size(); i++) {
+        const auto &range = block->freeRanges[i];
+        VkDeviceSize aligned = alignUp(range.offset, alignment);
+        if (aligned + size > range.offset + range.size || range.size >= bestSize) continue;
+        target = block.get();
+        rangeIndex = i;
+        bestSize = range.size;
+      }
+    }
+    if (!target) target = createBlock(memoryTypeIndex, kind, blockSize, false);
+  }
+
+  auto range = target->freeRanges[rangeIndex];
+  VkDeviceSize aligned = alignUp(range.offset, alignment);
+  VkDeviceSize front = aligned - range.offset;
+  VkDeviceSize back = range.offset + range.size - (aligned + size);
+
+  target->freeRanges.erase(target->freeRanges.begin() + rangeIndex);
+  if (back > 0) target->freeRanges.insert(target->freeRanges.begin() + rangeIndex, {aligned + size, back});
+  if (front > 0) target->freeRanges.insert(target->freeRanges.begin() + rangeIndex, {range.offset, front});
+  target->usedBytes += size;
+  target->allocationCount++;
+  auto &tagged = tagStats[static_cast<size_t>(tag)];
+  tagged.bytes += size;
+  tagged.allocationCount++;
+
+  LveAllocation allocation{};
+  allocation.memory = target->memory;
+  allocation.offset = aligned;
+  allocation.size = size;
+  allocation.mapped = target->mapped ? target->mapped + aligned : nullptr;
+  allocation.memoryTypeIndex = memoryTypeIndex;
+  allocation.tag = tag;
+  allocation.block = target;
+  return allocation;
+}
+
+void LveAllocator::free(LveAllocation &allocation) {
+  if (!allocation.isValid()) return;
+  std::lock_guard<std::mutex> lock{mutex};
+
+  auto *block = allocation.block;
+  auto &ranges = block->freeRanges;
+  auto it = std::lower_bound(ranges.begin(), ranges.end(), allocation.offset, [](const auto &r, VkDeviceSize offset) { return r.offset < offset; });
+  it = ranges.insert(it, {allocation.offset, allocation.size});
+
+  // merge with the following range first so the iterator stays valid for the preceding merge
+  auto next = it + 1;
+  if (next != ranges.end() && it->offset + it->size == next->offset) {
+    it->size += next->size;
+    ranges.erase(next);
+  }
+  if (it != ranges.begin()) {
+    auto prev = it - 1;
+    if (prev->offset + prev->size == it->offset) {
+      prev->size += it->size;
+      ranges.erase(it);
+    }
+  }
+
+  block->usedBytes -= allocation.size;
+  block->allocationCount--;
+  auto &tagged = tagStats[static_cast<size_t>(allocation.tag)];
+  tagged.bytes -= allocation.size;
+  tagged.allocationCount--;
+  allocation = LveAllocation{};
+
+  if (block->allocationCount > 0) return;
+  if (block->dedicated) {
+    destroyBlock(block);
+    return;
+  }
+
+  // keep a single empty block per type around to avoid thrashing on load/unload cycles
+  bool hasSpare = std::any_of(blocks.begin(), blocks.end(), [block](const auto &b) {
+    return b.get() != block && !b->dedicated && b->allocationCount == 0 && b->memoryTypeIndex == block->memoryTypeIndex && b->kind == block->kind;
+  });
+  if (hasSpare) destroyBlock(block);
+}
+
+VkMappedMemoryRange LveAllocator::mappedRange(const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const {
+  VkDeviceSize begin = allocation.offset + offset;
+  VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+  VkMappedMemoryRange range{};
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.memory = allocation.memory;
+  range.offset = alignDown(begin, nonCoherentAtomSize);
+  range.size = std::min(alignUp(end, nonCoherentAtomSize), allocation.block->size) - range.offset;
+  return range;
+}
+
+std::vector<LveHeapStats> LveAllocator::getHeapStats() const {
+  std::vector<LveHeapStats> stats(memoryProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+    stats[i].heapIndex = i;
+    stats[i].heapSize = memoryProperties.memoryHeaps[i].size;
+    stats[i].flags = memoryProperties.memoryHeaps[i].flags;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex};
+  for (const auto &block : blocks) {
+    auto &heap = stats[memoryProperties.memoryTypes[block->memoryTypeIndex].heapIndex];
+    heap.blockCount++;
+    if (block->dedicated) heap.dedicatedBlockCount++;
+    heap.allocationCount += block->allocationCount;
+    heap.reservedBytes += block->size;
+    heap.usedBytes += block->usedBytes;
+    for (const auto &range : block->freeRanges) heap.largestFreeRange = std::max(heap.largestFreeRange, range.size);
+  }
+  return stats;
+}
+
+LveTagStatsArray LveAllocator::getTagStats() const {
+  std::lock_guard<std::mutex> lock{mutex};
+  return tagStats;
+}
+
+void LveAllocator::printStats() const {
+  constexpr double mib = 1024.0 * 1024.0;
+  for (const auto &heap : getHeapStats()) {
+    if (heap.blockCount == 0) continue;
+    char line[256];
+    snprintf(
+        line,
+        sizeof(line),
+        "gpu heap %u (%s): %u blocks (%u dedicated), %u allocations, %.1f / %.1f mib used, fragmentation %.1f%%",
+        heap.heapIndex,
+        (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device local" : "host",
+        heap.blockCount,
+        heap.dedicatedBlockCount,
+        heap.allocationCount,
+        heap.usedBytes / mib,
+        heap.reservedBytes / mib,
+        heap.fragmentation() * 100.f);
+    std::cout << line << std::endl;
+  }
+
+  auto tags = getTagStats();
+  for (size_t i = 0; i < tags.size(); i++) {
+    if (tags[i].allocationCount == 0) continue;
+    char line[128];
+    snprintf(line, sizeof(line), "  %-10s %6u allocations, %.1f mib", memoryTagName(static_cast<LveMemoryTag>(i)), tags[i].allocationCount, tags[i].bytes / mib);
+    std::cout << line << std::endl;
+  }
+}
+
+}  // namespace lve
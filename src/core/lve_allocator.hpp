@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * block based gpu memory sub-allocator.
+ * carves buffers and images out of large per-memory-type blocks instead of
+ * calling vkAllocateMemory once per resource.
+ */
+
+namespace lve {
+
+struct LveMemoryBlock;
+
+/**
+ * resources with linear and optimal tiling live in separate blocks, so neighbouring
+ * ranges never violate bufferImageGranularity.
+ */
+enum class LveAllocationKind : uint8_t { Linear, Optimal };
+
+/**
+ * subsystem an allocation is charged to in the memory accounting.
+ */
+enum class LveMemoryTag : uint8_t { Mesh, Texture, ShadowMap, Ui, Staging, Uniform, Attachment, Other, Count };
+
+constexpr size_t LVE_MEMORY_TAG_COUNT = static_cast<size_t>(LveMemoryTag::Count);
+
+const char *memoryTagName(LveMemoryTag tag) noexcept;
+
+/**
+ * a range of device memory handed out by the allocator.
+ * mapped points at the start of the range when the memory type is host visible.
+ */
+struct LveAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  void *mapped = nullptr;
+  uint32_t memoryTypeIndex = 0;
+  LveMemoryTag tag = LveMemoryTag::Other;
+  LveMemoryBlock *block = nullptr;
+
+  bool isValid() const noexcept { return memory != VK_NULL_HANDLE; }
+};
+
+/**
+ * usage numbers for one memory heap, aggregated over every memory type that lives in it.
+ * fragmentation is 0 when all free space is one contiguous range and approaches 1 as it splinters.
+ */
+struct LveHeapStats {
+  uint32_t heapIndex = 0;
+  VkDeviceSize heapSize = 0;
+  VkMemoryHeapFlags flags = 0;
+  uint32_t blockCount = 0;
+  uint32_t dedicatedBlockCount = 0;
+  uint32_t allocationCount = 0;
+  VkDeviceSize reservedBytes = 0;
+  VkDeviceSize usedBytes = 0;
+  VkDeviceSize largestFreeRange = 0;
+
+  float fragmentation() const noexcept {
+    VkDeviceSize freeBytes = reservedBytes - usedBytes;
+    return freeBytes > 0 ? 1.f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes) : 0.f;
+  }
+};
+
+/** bytes handed out to one subsystem, excluding the unused space of the blocks they live in. */
+struct LveTagStats {
+  VkDeviceSize bytes = 0;
+  uint32_t allocationCount = 0;
+};
+
+using LveTagStatsArray = std::array<LveTagStats, LVE_MEMORY_TAG_COUNT>;
+
+/**
+ * budget of one memory heap as reported by VK_EXT_memory_budget.
+ * without the extension budget is estimated from the heap size and usage is what this process reserved.
+ */
+struct LveHeapBudget {
+  static constexpr float WARNING_RATIO = 0.9f;
+
+  uint32_t heapIndex = 0;
+  VkMemoryHeapFlags flags = 0;
+  VkDeviceSize heapSize = 0;
+  VkDeviceSize budget = 0;
+  VkDeviceSize usage = 0;
+  bool fromDriver = false;
+
+  float usageRatio() const noexcept { return budget > 0 ? static_cast<float>(usage) / static_cast<float>(budget) : 0.f; }
+  bool isNearBudget() const noexcept { return usageRatio() >= WARNING_RATIO; }
+};
+
+class LveAllocator {
+ public:
+  static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+  LveAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, const VkPhysicalDeviceLimits &limits);
+  ~LveAllocator();
+
+  LveAllocator(const LveAllocator &) = delete;
+  LveAllocator &operator=(const LveAllocator &) = delete;
+
+  /**
+   * sub-allocates a range satisfying the given requirements from a block of memoryTypeIndex.
+   * requests larger than half a block get a dedicated vkAllocateMemory of their own.
+   */
+  LveAllocation allocate(
+      const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, LveAllocationKind kind, LveMemoryTag tag = LveMemoryTag::Other);
+  void free(LveAllocation &allocation);
+
+  /**
+   * builds a flush/invalidate range for part of an allocation, widened to nonCoherentAtomSize.
+   * size and offset are relative to the allocation, VK_WHOLE_SIZE covers the rest of it.
+   */
+  VkMappedMemoryRange mappedRange(const LveAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+  std::vector<LveHeapStats> getHeapStats() const;
+  LveTagStatsArray getTagStats() const;
+  void printStats() const;
+
+ private:
+  VkDeviceSize blockSizeForType(uint32_t memoryTypeIndex) const noexcept;
+  LveMemoryBlock *createBlock(uint32_t memoryTypeIndex, LveAllocationKind kind, VkDeviceSize size, bool dedicated);
+  void destroyBlock(LveMemoryBlock *block);
+
+  VkDevice device;
+  VkPhysicalDeviceMemoryProperties memoryProperties;
+  VkDeviceSize nonCoherentAtomSize;
+
+  mutable std::mutex mutex;
+  std::vector<std::unique_ptr<LveMemoryBlock>> blocks;
+  LveTagStatsArray tagStats{};
+};
+
+}  // namespace lve
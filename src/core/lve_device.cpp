@@ -1,5 +1,6 @@
 #include "core/lve_device.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -46,9 +47,14 @@ LveDevice::LveDevice(LveWindow &window) : window{window} {
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createAllocator();
+  createUploadQueue();
 }
 
 LveDevice::~LveDevice() {
+  streamingQueue_.reset();
+  uploadQueue_.reset();
+  allocator_.reset();
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
   if (enableValidationLayers) DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
@@ -67,13 +73,16 @@ void LveDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "vlm engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
   createInfo.pApplicationInfo = &appInfo;
 
   auto extensions = getRequiredExtensions();
+  // optional, only needed to chain the memory budget query
+  properties2Enabled = isInstanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+  if (properties2Enabled) extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
   createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -117,7 +126,7 @@ void LveDevice::pickPhysicalDevice() {
 void LveDevice::createLogicalDevice() {
   auto indices = findQueueFamilies(physicalDevice);
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -129,16 +138,42 @@ void LveDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // pass statistics wrap render passes whose contents are secondaries, so they need both
+  pipelineStatisticsEnabled = supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries;
+  deviceFeatures.pipelineStatisticsQuery = pipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;
+  deviceFeatures.inheritedQueries = pipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;
+
+  VkPhysicalDeviceVulkan12Features supported12{};
+  supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceFeatures2 supported2{};
+  supported2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supported2.pNext = &supported12;
+  vkGetPhysicalDeviceFeatures2(physicalDevice, &supported2);
+
+  VkPhysicalDeviceVulkan12Features features12{};
+  features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  features12.timelineSemaphore = VK_TRUE;
+  // gpu driven draws index their instance data by firstInstance and pack many draws per call
+  indirectCountEnabled = supported12.drawIndirectCount && supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance;
+  features12.drawIndirectCount = indirectCountEnabled ? VK_TRUE : VK_FALSE;
+  deviceFeatures.multiDrawIndirect = indirectCountEnabled ? VK_TRUE : VK_FALSE;
+  deviceFeatures.drawIndirectFirstInstance = indirectCountEnabled ? VK_TRUE : VK_FALSE;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &features12;
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  std::vector<const char *> enabledExtensions = deviceExtensions;
+  bool memoryBudget = properties2Enabled && isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudget) enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   if (enableValidationLayers) {
     createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -153,6 +188,11 @@ void LveDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+
+  if (memoryBudget) {
+    getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+  }
 }
 
 void LveDevice::createCommandPool() {
@@ -167,6 +207,30 @@ void LveDevice::createCommandPool() {
   }
 }
 
+void LveDevice::createAllocator() {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  allocator_ = std::make_unique<LveAllocator>(device_, memProperties, properties.limits);
+
+  // discrete cards without resizable bar expose a 256mb host visible window as its own small heap,
+  // only count the type when it sits on the main device local heap
+  VkDeviceSize largestLocalHeap = 0;
+  for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+    if (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) largestLocalHeap = std::max(largestLocalHeap, memProperties.memoryHeaps[i].size);
+  }
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    const auto &type = memProperties.memoryTypes[i];
+    if ((type.propertyFlags & DIRECT_WRITE_PROPERTIES) == DIRECT_WRITE_PROPERTIES && memProperties.memoryHeaps[type.heapIndex].size == largestLocalHeap) {
+      hostVisibleDeviceLocal = true;
+    }
+  }
+}
+
+void LveDevice::createUploadQueue() {
+  uploadQueue_ = std::make_unique<LveUploadQueue>(*this, false);
+  if (findPhysicalQueueFamilies().hasDedicatedTransfer()) streamingQueue_ = std::make_unique<LveUploadQueue>(*this, true);
+}
+
 void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
 
 bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
@@ -179,7 +243,21 @@ bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
   }
   VkPhysicalDeviceFeatures supportedFeatures;
   vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-  return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+
+  // frame pacing is built on timeline semaphores, core since vulkan 1.2
+  VkPhysicalDeviceProperties deviceProperties;
+  vkGetPhysicalDeviceProperties(device, &deviceProperties);
+  bool timelineSemaphores = false;
+  if (deviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(device, &features2);
+    timelineSemaphores = features12.timelineSemaphore;
+  }
+  return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy && timelineSemaphores;
 }
 
 void LveDevice::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo) {
@@ -239,6 +317,22 @@ void LveDevice::hasGflwRequiredInstanceExtensions() {
   }
 }
 
+bool LveDevice::isInstanceExtensionAvailable(const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+  return std::any_of(extensions.begin(), extensions.end(), [name](const auto &e) { return strcmp(e.extensionName, name) == 0; });
+}
+
+bool LveDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+  return std::any_of(extensions.begin(), extensions.end(), [name](const auto &e) { return strcmp(e.extensionName, name) == 0; });
+}
+
 bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   uint32_t extensionCount;
   vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -249,6 +343,14 @@ bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+uint32_t LveDevice::timestampValidBits() {
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+  return queueFamilies[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+}
+
 QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
   uint32_t queueFamilyCount = 0;
@@ -271,6 +373,21 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
     if (indices.isComplete()) break;
     i++;
   }
+
+  // a transfer-only family maps to the copy engines, a compute family is the next best thing
+  indices.transferFamily = indices.graphicsFamily;
+  int bestScore = 0;
+  for (uint32_t f = 0; f < queueFamilyCount; f++) {
+    const auto &queueFamily = queueFamilies[f];
+    if (queueFamily.queueCount == 0 || (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) continue;
+    int score = 0;
+    if (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) score = (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+    else if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) score = 1;
+    if (score > bestScore) {
+      indices.transferFamily = f;
+      bestScore = score;
+    }
+  }
   return indices;
 }
 
@@ -311,7 +428,8 @@ uint32_t LveDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags pr
   throw std::runtime_error("failed to find suitable memory type");
 }
 
-void LveDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory) {
+void LveDevice::createBuffer(
+    VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, LveAllocation &bufferAllocation, LveMemoryTag tag) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -321,14 +439,15 @@ void LveDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemo
   if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) throw std::runtime_error("failed to create buffer");
   VkMemoryRequirements memReqs;
   vkGetBufferMemoryRequirements(device_, buffer, &memReqs);
-  
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memReqs.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memReqs.memoryTypeBits, properties);
-  
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) throw std::runtime_error("failed to allocate buffer memory");
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+
+  bufferAllocation = allocator_->allocate(memReqs, findMemoryType(memReqs.memoryTypeBits, properties), LveAllocationKind::Linear, tag);
+  if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS) throw std::runtime_error("failed to bind buffer memory");
+}
+
+void LveDevice::destroyBuffer(VkBuffer &buffer, LveAllocation &bufferAllocation) {
+  vkDestroyBuffer(device_, buffer, nullptr);
+  allocator_->free(bufferAllocation);
+  buffer = VK_NULL_HANDLE;
 }
 
 VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -356,11 +475,31 @@ void LveDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  {
+    std::lock_guard<std::mutex> lock{graphicsQueueMutex};
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(graphicsQueue_);
+  }
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
+std::mutex &LveDevice::queueMutex(VkQueue queue) {
+  // queue handles alias when families are shared, so pick the mutex by handle and not by role
+  if (queue == graphicsQueue_) return graphicsQueueMutex;
+  if (queue == presentQueue_) return presentQueueMutex;
+  return transferQueueMutex;
+}
+
+VkResult LveDevice::submit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *submits, VkFence fence) {
+  std::lock_guard<std::mutex> lock{queueMutex(queue)};
+  return vkQueueSubmit(queue, submitCount, submits, fence);
+}
+
+VkResult LveDevice::present(const VkPresentInfoKHR &presentInfo) {
+  std::lock_guard<std::mutex> lock{queueMutex(presentQueue_)};
+  return vkQueuePresentKHR(presentQueue_, &presentInfo);
+}
+
 void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
   VkBufferCopy copyRegion{};
@@ -386,16 +525,51 @@ void LveDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width
   endSingleTimeCommands(commandBuffer);
 }
 
-void LveDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory) {
+void LveDevice::createImageWithInfo(
+    const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, LveAllocation &imageAllocation, LveMemoryTag tag) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) throw std::runtime_error("failed to create image");
   VkMemoryRequirements memReqs;
   vkGetImageMemoryRequirements(device_, image, &memReqs);
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memReqs.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memReqs.memoryTypeBits, properties);
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) throw std::runtime_error("failed to allocate image memory");
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) throw std::runtime_error("failed to bind image memory");
+  auto kind = imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? LveAllocationKind::Linear : LveAllocationKind::Optimal;
+  imageAllocation = allocator_->allocate(memReqs, findMemoryType(memReqs.memoryTypeBits, properties), kind, tag);
+  if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) throw std::runtime_error("failed to bind image memory");
+}
+
+void LveDevice::destroyImage(VkImage &image, LveAllocation &imageAllocation) {
+  vkDestroyImage(device_, image, nullptr);
+  allocator_->free(imageAllocation);
+  image = VK_NULL_HANDLE;
+}
+
+std::vector<LveHeapBudget> LveDevice::queryMemoryBudget() const {
+  auto heaps = allocator_->getHeapStats();
+  std::vector<LveHeapBudget> budgets(heaps.size());
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  if (getMemoryProperties2) {
+    VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = &budgetProperties;
+    getMemoryProperties2(physicalDevice, &memoryProperties);
+  }
+
+  for (size_t i = 0; i < heaps.size(); i++) {
+    auto &budget = budgets[i];
+    budget.heapIndex = heaps[i].heapIndex;
+    budget.flags = heaps[i].flags;
+    budget.heapSize = heaps[i].heapSize;
+    budget.fromDriver = getMemoryProperties2 != nullptr;
+    if (budget.fromDriver) {
+      budget.budget = budgetProperties.heapBudget[i];
+      budget.usage = budgetProperties.heapUsage[i];
+    } else {
+      // the driver usually grants a process about 80% of a heap, and only our own blocks are visible
+      budget.budget = heaps[i].heapSize / 10 * 8;
+      budget.usage = heaps[i].reservedBytes;
+    }
+  }
+  return budgets;
 }
 
 }  // namespace lve
\ No newline at end of file
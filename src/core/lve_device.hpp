@@ -1,7 +1,11 @@
 #pragma once
 
+#include "core/lve_allocator.hpp"
+#include "core/lve_upload_queue.hpp"
 #include "core/lve_window.hpp"
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -21,9 +25,12 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  // falls back to graphicsFamily when the device has no separate transfer-capable family
+  uint32_t transferFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
   bool isComplete() const noexcept { return graphicsFamilyHasValue && presentFamilyHasValue; }
+  bool hasDedicatedTransfer() const noexcept { return transferFamily != graphicsFamily; }
 };
 
 class LveDevice {
@@ -47,21 +54,46 @@ class LveDevice {
   VkSurfaceKHR surface() const noexcept { return surface_; }
   VkQueue graphicsQueue() const noexcept { return graphicsQueue_; }
   VkQueue presentQueue() const noexcept { return presentQueue_; }
+  VkQueue transferQueue() const noexcept { return transferQueue_; }
   LveWindow &getWindow() const noexcept { return window; }
+  LveAllocator &allocator() const noexcept { return *allocator_; }
+  LveUploadQueue &uploadQueue() const noexcept { return *uploadQueue_; }
+  // asset streaming, runs on the transfer queue when the device has one
+  LveUploadQueue &streamingQueue() const noexcept { return streamingQueue_ ? *streamingQueue_ : *uploadQueue_; }
+
+  // queues are externally synchronized, so every submit and present goes through these
+  VkResult submit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *submits, VkFence fence);
+  VkResult present(const VkPresentInfoKHR &presentInfo);
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+  // device local memory the cpu can write in place (resizable bar, integrated gpus, software rasterizers)
+  bool hasHostVisibleDeviceLocal() const noexcept { return hostVisibleDeviceLocal; }
+  // for buffers the cpu fills once and the gpu reads: written in place when possible, else staged
+  VkMemoryPropertyFlags uploadMemoryProperties() const noexcept {
+    return hostVisibleDeviceLocal ? DIRECT_WRITE_PROPERTIES : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  }
+  // for buffers the cpu rewrites every frame
+  VkMemoryPropertyFlags dynamicMemoryProperties() const noexcept {
+    return hostVisibleDeviceLocal ? DIRECT_WRITE_PROPERTIES : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  }
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+  // meaningful bits of timestamps written on the graphics queue, 0 when it cannot write them
+  uint32_t timestampValidBits();
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
-  // buffer and image helpers
+  // buffer and image helpers, memory is sub-allocated through allocator().
+  // the single-time command helpers stall the queue, prefer uploadQueue() for asset data
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveAllocation &bufferAllocation,
+      LveMemoryTag tag = LveMemoryTag::Other);
+  void destroyBuffer(VkBuffer &buffer, LveAllocation &bufferAllocation);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -72,17 +104,32 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveAllocation &imageAllocation,
+      LveMemoryTag tag = LveMemoryTag::Other);
+  void destroyImage(VkImage &image, LveAllocation &imageAllocation);
+
+  // polls the driver's per-heap budget when VK_EXT_memory_budget is available, otherwise estimates it
+  std::vector<LveHeapBudget> queryMemoryBudget() const;
+  bool hasMemoryBudget() const noexcept { return getMemoryProperties2 != nullptr; }
+  // pipeline statistics queries that may stay active across vkCmdExecuteCommands
+  bool hasPipelineStatistics() const noexcept { return pipelineStatisticsEnabled; }
+  // vkCmdDrawIndexedIndirectCount with many draws and a non zero firstInstance, for gpu driven submission
+  bool hasIndirectCount() const noexcept { return indirectCountEnabled; }
 
   VkPhysicalDeviceProperties properties;
 
  private:
+  static constexpr VkMemoryPropertyFlags DIRECT_WRITE_PROPERTIES =
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
   void createInstance();
   void setupDebugMessenger();
   void createSurface();
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createAllocator();
+  void createUploadQueue();
 
   bool isDeviceSuitable(VkPhysicalDevice device);
   std::vector<const char *> getRequiredExtensions();
@@ -91,6 +138,8 @@ class LveDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  bool isInstanceExtensionAvailable(const char *name);
+  bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *name);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
@@ -103,6 +152,21 @@ class LveDevice {
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  std::unique_ptr<LveAllocator> allocator_;
+  VkQueue transferQueue_;
+  std::unique_ptr<LveUploadQueue> uploadQueue_;
+  std::unique_ptr<LveUploadQueue> streamingQueue_;
+
+  std::mutex &queueMutex(VkQueue queue);
+  std::mutex graphicsQueueMutex;
+  std::mutex presentQueueMutex;
+  std::mutex transferQueueMutex;
+
+  bool hostVisibleDeviceLocal = false;
+  bool properties2Enabled = false;
+  bool pipelineStatisticsEnabled = false;
+  bool indirectCountEnabled = false;
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -0,0 +1,41 @@
+#include "core/lve_frame_limiter.hpp"
+
+#include "core/lve_profiler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * frame limiter implementation.
+ * the spin margin follows the worst recent oversleep and decays slowly, so it settles near a
+ * scheduler tick on platforms with coarse timers and near zero elsewhere.
+ */
+
+namespace lve {
+
+void LveFrameLimiter::setTargetFps(float fps) noexcept {
+  targetFps = std::max(fps, 0.f);
+  period = targetFps > 0.f ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps)) : Clock::duration{};
+  nextFrame = Clock::time_point{};
+}
+
+void LveFrameLimiter::wait() {
+  if (!isEnabled()) return;
+  LVE_PROFILE_SCOPE("frame limiter");
+
+  auto now = Clock::now();
+  if (now < nextFrame) {
+    auto sleepUntil = nextFrame - sleepMargin;
+    if (now < sleepUntil) {
+      std::this_thread::sleep_until(sleepUntil);
+      auto oversleep = Clock::now() - sleepUntil;
+      sleepMargin = std::max(oversleep, sleepMargin - sleepMargin / 64);
+    }
+    while (Clock::now() < nextFrame) std::this_thread::yield();
+  } else if (now - nextFrame > period) {
+    nextFrame = now;
+  }
+  nextFrame += period;
+}
+
+}  // namespace lve
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * cpu side frame rate cap.
+ * sleeps most of the remaining frame time and spins the rest, so the cap holds to well under a
+ * millisecond even where os sleeps are coarse. called right before input is sampled, so the wait
+ * does not add latency between input and the frame that shows it.
+ */
+
+namespace lve {
+
+class LveFrameLimiter {
+ public:
+  LveFrameLimiter() = default;
+
+  LveFrameLimiter(const LveFrameLimiter &) = delete;
+  LveFrameLimiter &operator=(const LveFrameLimiter &) = delete;
+
+  // 0 or less turns the limiter off
+  void setTargetFps(float fps) noexcept;
+  float getTargetFps() const noexcept { return targetFps; }
+  bool isEnabled() const noexcept { return targetFps > 0.f; }
+
+  /** blocks until the next frame is due. frames that run late reset the cadence instead of bursting to catch up. */
+  void wait();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  float targetFps = 0.f;
+  Clock::duration period{};
+  Clock::time_point nextFrame{};
+  // recent worst oversleep, left to spinning so the sleep itself never overshoots the deadline
+  Clock::duration sleepMargin = std::chrono::milliseconds(1);
+};
+
+}  // namespace lve
@@ -0,0 +1,191 @@
+#include "core/lve_profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * profiler implementation.
+ * each thread registers a ring on its first event. the ring's mutex is only ever contended
+ * by an export, so recording stays cheap while still giving the exporter a consistent view.
+ */
+
+namespace lve {
+
+namespace {
+
+enum class EventType : uint8_t { Zone, Counter, Frame };
+
+struct Event {
+  const char *name;
+  uint64_t start;
+  // zone duration in ns, counter value, or frame number
+  union {
+    uint64_t duration;
+    double value;
+  };
+  EventType type;
+};
+
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<Event> events;
+  uint64_t written = 0;
+  uint32_t threadId = 0;
+  std::string name;
+
+  void push(const Event &event) {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (events.empty()) events.resize(LveProfiler::EVENTS_PER_THREAD);
+    events[written % events.size()] = event;
+    written++;
+  }
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> threads;
+  std::atomic<uint64_t> frameNumber{0};
+  const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+ThreadBuffer &threadBuffer() {
+  // shared so a buffer survives its thread until the next export
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto &reg = registry();
+    auto created = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock{reg.mutex};
+    created->threadId = static_cast<uint32_t>(reg.threads.size() + 1);
+    reg.threads.push_back(created);
+    return created;
+  }();
+  return *buffer;
+}
+
+void writeEscaped(FILE *file, const char *text) {
+  for (const char *c = text; *c; c++) {
+    if (*c == '"' || *c == '\\') fputc('\\', file);
+    fputc(*c, file);
+  }
+}
+
+}  // namespace
+
+std::atomic<bool> LveProfiler::enabled{false};
+
+uint64_t LveProfiler::now() noexcept {
+  auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+  // never 0, zones use it to tell whether they were started while enabled
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) + 1;
+}
+
+void LveProfiler::recordZone(const char *name, uint64_t startNs, uint64_t endNs) {
+  Event event{};
+  event.name = name;
+  event.start = startNs;
+  event.duration = endNs - startNs;
+  event.type = EventType::Zone;
+  threadBuffer().push(event);
+}
+
+void LveProfiler::recordCounter(const char *name, double value) {
+  Event event{};
+  event.name = name;
+  event.start = now();
+  event.value = value;
+  event.type = EventType::Counter;
+  threadBuffer().push(event);
+}
+
+void LveProfiler::frameMark() {
+  Event event{};
+  event.name = "frame";
+  event.start = now();
+  event.duration = registry().frameNumber.fetch_add(1, std::memory_order_relaxed);
+  event.type = EventType::Frame;
+  threadBuffer().push(event);
+}
+
+void LveProfiler::setThreadName(const std::string &name) {
+  auto &buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock{buffer.mutex};
+  buffer.name = name;
+}
+
+bool LveProfiler::exportChromeTrace(const std::string &path) {
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file) return false;
+
+  std::vector<std::shared_ptr<ThreadBuffer>> threads;
+  {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock{reg.mutex};
+    threads = reg.threads;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  auto separator = [&] {
+    if (!first) fprintf(file, ",\n");
+    first = false;
+  };
+
+  for (auto &thread : threads) {
+    std::lock_guard<std::mutex> lock{thread->mutex};
+    if (!thread->name.empty()) {
+      separator();
+      fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", thread->threadId);
+      writeEscaped(file, thread->name.c_str());
+      fprintf(file, "\"}}");
+    }
+
+    uint64_t count = std::min<uint64_t>(thread->written, thread->events.size());
+    for (uint64_t i = thread->written - count; i < thread->written; i++) {
+      const auto &event = thread->events[i % thread->events.size()];
+      double ts = event.start / 1000.0;
+      separator();
+      switch (event.type) {
+        case EventType::Zone:
+          fprintf(file, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"", thread->threadId, ts, event.duration / 1000.0);
+          writeEscaped(file, event.name);
+          fprintf(file, "\"}");
+          break;
+        case EventType::Counter:
+          fprintf(file, "{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"", thread->threadId, ts);
+          writeEscaped(file, event.name);
+          fprintf(file, "\",\"args\":{\"value\":%g}}", event.value);
+          break;
+        case EventType::Frame:
+          fprintf(file, "{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"frame\",\"args\":{\"frame\":%llu}}", thread->threadId, ts, static_cast<unsigned long long>(event.duration));
+          break;
+      }
+    }
+  }
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return true;
+}
+
+void LveProfiler::clear() {
+  std::vector<std::shared_ptr<ThreadBuffer>> threads;
+  {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock{reg.mutex};
+    threads = reg.threads;
+  }
+  for (auto &thread : threads) {
+    std::lock_guard<std::mutex> lock{thread->mutex};
+    thread->written = 0;
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * cpu frame profiler.
+ * scoped zones, counters and frame markers go into per-thread ring buffers and can be written
+ * out as chrome trace json (chrome://tracing, perfetto). recording is off by default and a
+ * disabled zone costs one relaxed atomic load; define LVE_DISABLE_PROFILER to compile it out.
+ */
+
+namespace lve {
+
+class LveProfiler {
+ public:
+  // events kept per thread, older ones are overwritten
+  static constexpr uint32_t EVENTS_PER_THREAD = 1u << 16;
+
+  static bool isEnabled() noexcept { return enabled.load(std::memory_order_relaxed); }
+  static void setEnabled(bool value) noexcept { enabled.store(value, std::memory_order_relaxed); }
+
+  static uint64_t now() noexcept;
+
+  // name must outlive the capture, in practice a string literal
+  static void recordZone(const char *name, uint64_t startNs, uint64_t endNs);
+  static void recordCounter(const char *name, double value);
+  static void frameMark();
+  static void setThreadName(const std::string &name);
+
+  /** writes every buffered event as chrome trace json, returns false when the file cannot be opened. */
+  static bool exportChromeTrace(const std::string &path);
+  static void clear();
+
+ private:
+  static std::atomic<bool> enabled;
+};
+
+class LveProfileZone {
+ public:
+  explicit LveProfileZone(const char *name) noexcept : name{name}, start{LveProfiler::isEnabled() ? LveProfiler::now() : 0} {}
+  ~LveProfileZone() {
+    if (start && LveProfiler::isEnabled()) LveProfiler::recordZone(name, start, LveProfiler::now());
+  }
+
+  LveProfileZone(const LveProfileZone &) = delete;
+  LveProfileZone &operator=(const LveProfileZone &) = delete;
+
+ private:
+  const char *name;
+  uint64_t start;
+};
+
+}  // namespace lve
+
+#ifndef LVE_DISABLE_PROFILER
+#define LVE_PROFILE_CONCAT_INNER(a, b) a##b
+#define LVE_PROFILE_CONCAT(a, b) LVE_PROFILE_CONCAT_INNER(a, b)
+#define LVE_PROFILE_SCOPE(name) ::lve::LveProfileZone LVE_PROFILE_CONCAT(lveProfileZone, __LINE__){name}
+#define LVE_PROFILE_FUNCTION() LVE_PROFILE_SCOPE(__func__)
+#define LVE_PROFILE_COUNTER(name, value) \
+  do {                                   \
+    if (::lve::LveProfiler::isEnabled()) ::lve::LveProfiler::recordCounter(name, static_cast<double>(value)); \
+  } while (0)
+#define LVE_PROFILE_FRAME()                                          \
+  do {                                                               \
+    if (::lve::LveProfiler::isEnabled()) ::lve::LveProfiler::frameMark(); \
+  } while (0)
+#define LVE_PROFILE_THREAD(name) ::lve::LveProfiler::setThreadName(name)
+#else
+#define LVE_PROFILE_SCOPE(name) ((void)0)
+#define LVE_PROFILE_FUNCTION() ((void)0)
+#define LVE_PROFILE_COUNTER(name, value) ((void)0)
+#define LVE_PROFILE_FRAME() ((void)0)
+#define LVE_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,79 @@
+#include "core/lve_thread_pool.hpp"
+
+#include "core/lve_profiler.hpp"
+
+#include <algorithm>
+#include <string>
+
+/**
+ * thread pool implementation.
+ * tasks are claimed one index at a time under the pool mutex; they are coarse (a few hundred
+ * draws each), so contention on it is negligible next to the work itself.
+ */
+
+namespace lve {
+
+LveThreadPool::LveThreadPool(uint32_t threadCount) {
+  threadCount = std::max(threadCount, 1u);
+  workers.reserve(threadCount);
+  for (uint32_t i = 0; i < threadCount; i++) workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+LveThreadPool::~LveThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers) worker.join();
+}
+
+uint32_t LveThreadPool::defaultThreadCount() noexcept {
+  uint32_t cores = std::thread::hardware_concurrency();
+  return std::clamp(cores > 1 ? cores - 1 : 1u, 1u, 8u);
+}
+
+void LveThreadPool::run(uint32_t count, const Task &task) {
+  if (count == 0) return;
+
+  std::unique_lock<std::mutex> lock{mutex};
+  currentTask = &task;
+  taskCount = count;
+  nextTask = 0;
+  busyWorkers = getThreadCount();
+  error = nullptr;
+  generation++;
+  wake.notify_all();
+
+  done.wait(lock, [this] { return busyWorkers == 0; });
+  currentTask = nullptr;
+  if (error) std::rethrow_exception(error);
+}
+
+void LveThreadPool::workerLoop(uint32_t worker) {
+  LVE_PROFILE_THREAD("worker " + std::to_string(worker));
+  uint64_t seenGeneration = 0;
+  std::unique_lock<std::mutex> lock{mutex};
+  while (true) {
+    wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+    if (stopping) return;
+    seenGeneration = generation;
+
+    while (nextTask < taskCount) {
+      uint32_t task = nextTask++;
+      lock.unlock();
+      try {
+        (*currentTask)(task, worker);
+      } catch (...) {
+        lock.lock();
+        if (!error) error = std::current_exception();
+        continue;
+      }
+      lock.lock();
+    }
+
+    if (--busyWorkers == 0) done.notify_one();
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * fixed set of worker threads for fork/join work inside a frame.
+ * run() hands out task indices to the workers and blocks until all of them are done,
+ * so callers can capture frame locals by reference.
+ */
+
+namespace lve {
+
+class LveThreadPool {
+ public:
+  using Task = std::function<void(uint32_t task, uint32_t worker)>;
+
+  explicit LveThreadPool(uint32_t threadCount);
+  ~LveThreadPool();
+
+  LveThreadPool(const LveThreadPool &) = delete;
+  LveThreadPool &operator=(const LveThreadPool &) = delete;
+
+  /**
+   * calls task(i, worker) for every i in [0, taskCount). worker is the index of the thread
+   * running it, stable for the duration of the call, so it can select per-thread resources.
+   * rethrows the first exception thrown by a task. not reentrant.
+   */
+  void run(uint32_t taskCount, const Task &task);
+
+  uint32_t getThreadCount() const noexcept { return static_cast<uint32_t>(workers.size()); }
+
+  /** one worker per core, leaving a core to the thread that calls run(). */
+  static uint32_t defaultThreadCount() noexcept;
+
+ private:
+  void workerLoop(uint32_t worker);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+
+  const Task *currentTask = nullptr;
+  uint32_t taskCount = 0;
+  uint32_t nextTask = 0;
+  uint32_t busyWorkers = 0;
+  uint64_t generation = 0;
+  bool stopping = false;
+  std::exception_ptr error;
+};
+
+}  // namespace lve
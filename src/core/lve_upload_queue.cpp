@@ -0,0 +1,416 @@
+#include "core/lve_upload_queue.hpp"
+#include "core/lve_device.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * upload queue implementation.
+ * ring space is reclaimed in submission order as fences signal; requests larger than half
+ * the ring get a temporary staging buffer that lives until its submission completes.
+ */
+
+namespace lve {
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) noexcept {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkCommandPool createPool(VkDevice device, uint32_t queueFamily) {
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.queueFamilyIndex = queueFamily;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  VkCommandPool pool;
+  if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) throw std::runtime_error("failed to create upload command pool");
+  return pool;
+}
+
+static VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool pool) {
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.commandPool = pool;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = 1;
+  VkCommandBuffer commandBuffer;
+  if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to allocate upload command buffer");
+  return commandBuffer;
+}
+
+LveUploadQueue::LveUploadQueue(LveDevice &device, bool useTransferQueue, VkDeviceSize ringSize) : lveDevice{device}, ringSize{ringSize} {
+  auto indices = lveDevice.findPhysicalQueueFamilies();
+  ownershipTransfer = useTransferQueue && indices.hasDedicatedTransfer();
+  graphicsFamily = indices.graphicsFamily;
+  queueFamily = ownershipTransfer ? indices.transferFamily : indices.graphicsFamily;
+  queue = ownershipTransfer ? lveDevice.transferQueue() : lveDevice.graphicsQueue();
+
+  commandPool = createPool(lveDevice.device(), queueFamily);
+  if (ownershipTransfer) acquirePool = createPool(lveDevice.device(), graphicsFamily);
+
+  lveDevice.createBuffer(ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ringBuffer, ringAllocation, LveMemoryTag::Staging);
+  if (!ringAllocation.mapped) throw std::runtime_error("upload ring is not host mapped");
+}
+
+LveUploadQueue::~LveUploadQueue() {
+  waitIdle();
+  for (auto &submission : freeSubmissions) {
+    vkDestroyFence(lveDevice.device(), submission.fence, nullptr);
+    if (submission.transferDone) vkDestroySemaphore(lveDevice.device(), submission.transferDone, nullptr);
+  }
+  vkDestroyCommandPool(lveDevice.device(), commandPool, nullptr);
+  if (acquirePool) vkDestroyCommandPool(lveDevice.device(), acquirePool, nullptr);
+  lveDevice.destroyBuffer(ringBuffer, ringAllocation);
+}
+
+LveUploadQueue::Ticket LveUploadQueue::enqueueBufferUpload(
+    VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+  if (size == 0) return nextTicket;
+  std::lock_guard<std::mutex> lock{mutex};
+
+  auto staging = stage(data, size, 16);
+  auto cmd = recordingCommandBuffer();
+
+  // a second write to the same buffer in this batch must not race the first one
+  bool touched = std::any_of(pendingBufferBarriers.begin(), pendingBufferBarriers.end(), [dstBuffer](const auto &b) { return b.buffer == dstBuffer; });
+  if (touched) {
+    VkMemoryBarrier waw{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT};
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &waw, 0, nullptr, 0, nullptr);
+  }
+
+  VkBufferCopy region{};
+  region.srcOffset = staging.offset;
+  region.dstOffset = dstOffset;
+  region.size = size;
+  vkCmdCopyBuffer(cmd, staging.buffer, dstBuffer, 1, &region);
+
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = dstAccess;
+  barrier.srcQueueFamilyIndex = ownershipTransfer ? queueFamily : VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = ownershipTransfer ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = dstBuffer;
+  barrier.offset = dstOffset;
+  barrier.size = size;
+  pendingBufferBarriers.push_back(barrier);
+  pendingDstStages |= dstStage;
+  return nextTicket;
+}
+
+LveUploadQueue::Ticket LveUploadQueue::enqueueImageUpload(
+    VkImage dstImage,
+    const void *data,
+    VkDeviceSize size,
+    uint32_t width,
+    uint32_t height,
+    VkImageLayout oldLayout,
+    VkImageLayout newLayout,
+    VkPipelineStageFlags dstStage,
+    VkAccessFlags dstAccess) {
+  assert((!ownershipTransfer || oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) && "transfer queue uploads need a fresh image");
+  std::lock_guard<std::mutex> lock{mutex};
+
+  VkDeviceSize alignment = std::max<VkDeviceSize>(16, lveDevice.properties.limits.optimalBufferCopyOffsetAlignment);
+  auto staging = stage(data, size, alignment);
+  auto cmd = recordingCommandBuffer();
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = oldLayout;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = dstImage;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  // an earlier upload in this batch already left the image in transfer dst with its
+  // final transition still pending, so only the copies have to be ordered
+  bool touched = std::any_of(pendingImageBarriers.begin(), pendingImageBarriers.end(), [dstImage](const auto &b) { return b.image == dstImage; });
+  if (touched) {
+    VkMemoryBarrier waw{VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT};
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &waw, 0, nullptr, 0, nullptr);
+  } else {
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    // reads by earlier frames only need an execution dependency before being overwritten
+    VkPipelineStageFlags srcStage = oldLayout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : dstStage;
+    vkCmdPipelineBarrier(cmd, srcStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+  }
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = staging.offset;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+  vkCmdCopyBufferToImage(cmd, staging.buffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+  if (touched) return nextTicket;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = newLayout;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = dstAccess;
+  barrier.srcQueueFamilyIndex = ownershipTransfer ? queueFamily : VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = ownershipTransfer ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+  pendingImageBarriers.push_back(barrier);
+  pendingDstStages |= dstStage;
+  return nextTicket;
+}
+
+LveUploadQueue::Ticket LveUploadQueue::flush() {
+  std::lock_guard<std::mutex> lock{mutex};
+  if (batchDepth > 0) return nextTicket;
+  return flushLocked();
+}
+
+void LveUploadQueue::beginBatch() {
+  std::lock_guard<std::mutex> lock{mutex};
+  batchDepth++;
+}
+
+LveUploadQueue::Ticket LveUploadQueue::endBatch() {
+  std::lock_guard<std::mutex> lock{mutex};
+  assert(batchDepth > 0 && "upload batch ended twice");
+  if (--batchDepth > 0) return nextTicket;
+  return flushLocked();
+}
+
+LveUploadQueue::Ticket LveUploadQueue::flushLocked() {
+  if (!recording) return nextTicket - 1;
+
+  emitPendingBarriers(current.commandBuffer);
+  if (vkEndCommandBuffer(current.commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record upload command buffer");
+
+  current.ticket = nextTicket++;
+  current.ringEnd = ringHead;
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &current.commandBuffer;
+
+  if (!ownershipTransfer) {
+    if (lveDevice.submit(queue, 1, &submitInfo, current.fence) != VK_SUCCESS) throw std::runtime_error("failed to submit upload command buffer");
+  } else {
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &current.transferDone;
+    if (lveDevice.submit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) throw std::runtime_error("failed to submit upload command buffer");
+
+    // the acquire half goes on the graphics queue, so frames submitted after it see the data
+    recordAcquire(current.acquireCommandBuffer);
+    VkPipelineStageFlags waitStage = acquireDstStages;
+    VkSubmitInfo acquireInfo{};
+    acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    acquireInfo.waitSemaphoreCount = 1;
+    acquireInfo.pWaitSemaphores = &current.transferDone;
+    acquireInfo.pWaitDstStageMask = &waitStage;
+    acquireInfo.commandBufferCount = 1;
+    acquireInfo.pCommandBuffers = &current.acquireCommandBuffer;
+    if (lveDevice.submit(lveDevice.graphicsQueue(), 1, &acquireInfo, current.fence) != VK_SUCCESS) throw std::runtime_error("failed to submit upload acquire");
+  }
+
+  inFlight.push_back(std::move(current));
+  current = Submission{};
+  recording = false;
+  return inFlight.back().ticket;
+}
+
+bool LveUploadQueue::isComplete(Ticket ticket) {
+  std::lock_guard<std::mutex> lock{mutex};
+  retireCompleted();
+  return ticket <= completedTicket;
+}
+
+void LveUploadQueue::wait(Ticket ticket) {
+  std::lock_guard<std::mutex> lock{mutex};
+  if (ticket >= nextTicket && recording) flushLocked();
+  while (completedTicket < ticket && !inFlight.empty()) retireOldest();
+}
+
+void LveUploadQueue::waitIdle() {
+  std::lock_guard<std::mutex> lock{mutex};
+  flushLocked();
+  while (!inFlight.empty()) retireOldest();
+}
+
+LveUploadQueue::Staging LveUploadQueue::stage(const void *data, VkDeviceSize size, VkDeviceSize alignment) {
+  retireCompleted();
+
+  if (size > ringSize / 2) {
+    recordingCommandBuffer();
+    TempStaging temp{};
+    lveDevice.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, temp.buffer, temp.allocation, LveMemoryTag::Staging);
+    std::memcpy(temp.allocation.mapped, data, size);
+    current.tempStaging.push_back(temp);
+    return {temp.buffer, 0};
+  }
+
+  uint64_t position;
+  while (!tryReserveRing(size, alignment, position)) {
+    if (!inFlight.empty()) {
+      retireOldest();
+    } else if (recording) {
+      flushLocked();
+    } else {
+      throw std::runtime_error("upload ring exhausted");
+    }
+  }
+
+  VkDeviceSize offset = position % ringSize;
+  std::memcpy(static_cast<char *>(ringAllocation.mapped) + offset, data, size);
+  return {ringBuffer, offset};
+}
+
+bool LveUploadQueue::tryReserveRing(VkDeviceSize size, VkDeviceSize alignment, uint64_t &position) {
+  uint64_t start = alignUp(ringHead, alignment);
+  // ranges never straddle the end of the ring, skip to the start of the next lap instead
+  if (start % ringSize + size > ringSize) start = alignUp(ringHead, ringSize);
+  if (start + size - ringTail > ringSize) return false;
+  ringHead = start + size;
+  position = start;
+  return true;
+}
+
+VkCommandBuffer LveUploadQueue::recordingCommandBuffer() {
+  if (recording) return current.commandBuffer;
+
+  if (!freeSubmissions.empty()) {
+    current = std::move(freeSubmissions.back());
+    freeSubmissions.pop_back();
+  } else {
+    current.commandBuffer = allocateCommandBuffer(lveDevice.device(), commandPool);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &current.fence) != VK_SUCCESS) throw std::runtime_error("failed to create upload fence");
+
+    if (ownershipTransfer) {
+      current.acquireCommandBuffer = allocateCommandBuffer(lveDevice.device(), acquirePool);
+      VkSemaphoreCreateInfo semaphoreInfo{};
+      semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, nullptr, &current.transferDone) != VK_SUCCESS) throw std::runtime_error("failed to create upload semaphore");
+    }
+  }
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(current.commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin upload command buffer");
+  recording = true;
+  return current.commandBuffer;
+}
+
+void LveUploadQueue::emitPendingBarriers(VkCommandBuffer cmd) {
+  if (pendingBufferBarriers.empty() && pendingImageBarriers.empty()) return;
+
+  if (!ownershipTransfer) {
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        pendingDstStages,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(pendingBufferBarriers.size()),
+        pendingBufferBarriers.data(),
+        static_cast<uint32_t>(pendingImageBarriers.size()),
+        pendingImageBarriers.data());
+  } else {
+    // the release half ignores dst access, the acquire half repeats the barrier with src access dropped
+    for (auto &barrier : pendingBufferBarriers) {
+      acquireBufferBarriers.push_back(barrier);
+      acquireBufferBarriers.back().srcAccessMask = 0;
+      barrier.dstAccessMask = 0;
+    }
+    for (auto &barrier : pendingImageBarriers) {
+      acquireImageBarriers.push_back(barrier);
+      acquireImageBarriers.back().srcAccessMask = 0;
+      barrier.dstAccessMask = 0;
+    }
+    acquireDstStages |= pendingDstStages;
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(pendingBufferBarriers.size()),
+        pendingBufferBarriers.data(),
+        static_cast<uint32_t>(pendingImageBarriers.size()),
+        pendingImageBarriers.data());
+  }
+  pendingBufferBarriers.clear();
+  pendingImageBarriers.clear();
+  pendingDstStages = 0;
+}
+
+void LveUploadQueue::recordAcquire(VkCommandBuffer cmd) {
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin upload acquire");
+  vkCmdPipelineBarrier(
+      cmd,
+      acquireDstStages,
+      acquireDstStages,
+      0,
+      0,
+      nullptr,
+      static_cast<uint32_t>(acquireBufferBarriers.size()),
+      acquireBufferBarriers.data(),
+      static_cast<uint32_t>(acquireImageBarriers.size()),
+      acquireImageBarriers.data());
+  if (vkEndCommandBuffer(cmd) != VK_SUCCESS) throw std::runtime_error("failed to record upload acquire");
+
+  acquireBufferBarriers.clear();
+  acquireImageBarriers.clear();
+  acquireDstStages = 0;
+}
+
+void LveUploadQueue::retireCompleted() {
+  while (!inFlight.empty() && vkGetFenceStatus(lveDevice.device(), inFlight.front().fence) == VK_SUCCESS) recycle(inFlight.front());
+}
+
+void LveUploadQueue::retireOldest() {
+  vkWaitForFences(lveDevice.device(), 1, &inFlight.front().fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+  recycle(inFlight.front());
+}
+
+void LveUploadQueue::recycle(Submission &submission) {
+  ringTail = submission.ringEnd;
+  completedTicket = submission.ticket;
+  for (auto &temp : submission.tempStaging) lveDevice.destroyBuffer(temp.buffer, temp.allocation);
+  submission.tempStaging.clear();
+
+  vkResetFences(lveDevice.device(), 1, &submission.fence);
+  vkResetCommandBuffer(submission.commandBuffer, 0);
+  if (submission.acquireCommandBuffer) vkResetCommandBuffer(submission.acquireCommandBuffer, 0);
+  freeSubmissions.push_back(std::move(submission));
+  inFlight.pop_front();
+}
+
+LveUploadBatch::LveUploadBatch(LveUploadQueue &queue) : uploadQueue{queue} { uploadQueue.beginBatch(); }
+
+LveUploadBatch::~LveUploadBatch() {
+  if (open) end();
+}
+
+LveUploadBatch::Ticket LveUploadBatch::end() {
+  assert(open && "upload batch already ended");
+  open = false;
+  return uploadQueue.endBatch();
+}
+
+}  // namespace lve
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "core/lve_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * asynchronous gpu upload queue.
+ * copies data into a persistently mapped staging ring and records the transfers,
+ * barriers and layout transitions into one command buffer that is submitted per flush.
+ * all public calls are thread safe, so loaders can enqueue from worker threads.
+ * LveUploadBatch groups a whole load into one submission.
+ */
+
+namespace lve {
+
+class LveDevice;
+
+class LveUploadQueue {
+ public:
+  using Ticket = uint64_t;
+
+  static constexpr VkDeviceSize DEFAULT_RING_SIZE = 64ull * 1024 * 1024;
+
+  /**
+   * with useTransferQueue the copies run on the device's transfer family and every resource is
+   * released to the graphics family, then acquired by a small graphics submit that waits on the
+   * transfer through a semaphore. resources uploaded that way must be fresh (oldLayout undefined).
+   */
+  LveUploadQueue(LveDevice &device, bool useTransferQueue, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+  ~LveUploadQueue();
+
+  LveUploadQueue(const LveUploadQueue &) = delete;
+  LveUploadQueue &operator=(const LveUploadQueue &) = delete;
+
+  /**
+   * stages size bytes of data for dstBuffer at dstOffset.
+   * dstStage/dstAccess describe the first consumer so the release barrier can be scoped to it.
+   */
+  Ticket enqueueBufferUpload(
+      VkBuffer dstBuffer,
+      const void *data,
+      VkDeviceSize size,
+      VkDeviceSize dstOffset = 0,
+      VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+      VkAccessFlags dstAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+
+  /**
+   * stages tightly packed texels for mip 0 / layer 0 of a color image and records the
+   * oldLayout -> transfer dst -> newLayout transitions around the copy.
+   */
+  Ticket enqueueImageUpload(
+      VkImage dstImage,
+      const void *data,
+      VkDeviceSize size,
+      uint32_t width,
+      uint32_t height,
+      VkImageLayout oldLayout,
+      VkImageLayout newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT);
+
+  /**
+   * submits everything recorded since the last flush. queue submission order makes the
+   * uploads visible to any frame submitted afterwards, so callers never wait on the cpu.
+   * while a batch is open this is a no-op and the batch's end submits instead.
+   */
+  Ticket flush();
+
+  bool isComplete(Ticket ticket);
+  void wait(Ticket ticket);
+  void waitIdle();
+
+  Ticket pendingTicket() const noexcept { return nextTicket; }
+  bool usesTransferQueue() const noexcept { return ownershipTransfer; }
+  VkDeviceSize getRingSize() const noexcept { return ringSize; }
+  bool isBatching() const noexcept { return batchDepth > 0; }
+
+ private:
+  friend class LveUploadBatch;
+
+  void beginBatch();
+  Ticket endBatch();
+
+  struct TempStaging {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    LveAllocation allocation{};
+  };
+
+  struct Submission {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    // only used with ownership transfer: graphics side acquire and the semaphore it waits on
+    VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+    VkSemaphore transferDone = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    Ticket ticket = 0;
+    uint64_t ringEnd = 0;
+    std::vector<TempStaging> tempStaging;
+  };
+
+  struct Staging {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+  };
+
+  Staging stage(const void *data, VkDeviceSize size, VkDeviceSize alignment);
+  bool tryReserveRing(VkDeviceSize size, VkDeviceSize alignment, uint64_t &offset);
+  Ticket flushLocked();
+  VkCommandBuffer recordingCommandBuffer();
+  void emitPendingBarriers(VkCommandBuffer cmd);
+  void recordAcquire(VkCommandBuffer cmd);
+  void retireCompleted();
+  void retireOldest();
+  void recycle(Submission &submission);
+
+  LveDevice &lveDevice;
+  bool ownershipTransfer;
+  VkQueue queue;
+  uint32_t queueFamily;
+  uint32_t graphicsFamily;
+  VkCommandPool commandPool = VK_NULL_HANDLE;
+  VkCommandPool acquirePool = VK_NULL_HANDLE;
+  std::mutex mutex;
+
+  VkBuffer ringBuffer = VK_NULL_HANDLE;
+  LveAllocation ringAllocation{};
+  VkDeviceSize ringSize;
+  // monotonically increasing positions, the physical offset is position % ringSize
+  uint64_t ringHead = 0;
+  uint64_t ringTail = 0;
+
+  Submission current{};
+  bool recording = false;
+  std::vector<VkBufferMemoryBarrier> pendingBufferBarriers;
+  std::vector<VkImageMemoryBarrier> pendingImageBarriers;
+  VkPipelineStageFlags pendingDstStages = 0;
+  std::vector<VkBufferMemoryBarrier> acquireBufferBarriers;
+  std::vector<VkImageMemoryBarrier> acquireImageBarriers;
+  VkPipelineStageFlags acquireDstStages = 0;
+
+  std::deque<Submission> inFlight;
+  std::vector<Submission> freeSubmissions;
+  Ticket nextTicket = 1;
+  Ticket completedTicket = 0;
+  uint32_t batchDepth = 0;
+};
+
+/**
+ * scope that records every upload made through a queue into a single submission.
+ * uploads issued indirectly (model and texture constructors) land in the batch as well,
+ * since it holds back the queue's flushes until end(). batches nest, only the outermost
+ * one submits. a batch that outgrows the staging ring is split where the ring runs dry.
+ */
+class LveUploadBatch {
+ public:
+  using Ticket = LveUploadQueue::Ticket;
+
+  explicit LveUploadBatch(LveUploadQueue &queue);
+  ~LveUploadBatch();
+
+  LveUploadBatch(const LveUploadBatch &) = delete;
+  LveUploadBatch &operator=(const LveUploadBatch &) = delete;
+
+  Ticket uploadBuffer(
+      VkBuffer dstBuffer,
+      const void *data,
+      VkDeviceSize size,
+      VkDeviceSize dstOffset = 0,
+      VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+      VkAccessFlags dstAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT) {
+    return uploadQueue.enqueueBufferUpload(dstBuffer, data, size, dstOffset, dstStage, dstAccess);
+  }
+
+  Ticket uploadImage(
+      VkImage dstImage,
+      const void *data,
+      VkDeviceSize size,
+      uint32_t width,
+      uint32_t height,
+      VkImageLayout oldLayout,
+      VkImageLayout newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT) {
+    return uploadQueue.enqueueImageUpload(dstImage, data, size, width, height, oldLayout, newLayout, dstStage, dstAccess);
+  }
+
+  /**
+   * closes the batch and submits it with one fence. the returned ticket can be waited on.
+   */
+  Ticket end();
+  void endAndWait() { uploadQueue.wait(end()); }
+
+  bool isOpen() const noexcept { return open; }
+
+ private:
+  LveUploadQueue &uploadQueue;
+  bool open = true;
+};
+
+}  // namespace lve
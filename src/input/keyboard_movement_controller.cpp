@@ -9,7 +9,7 @@
 
 namespace lve {
 
-void KeyboardMovementController::moveFree(GLFWwindow* window, float dt, LveGameObject& obj) {
+void KeyboardMovementController::moveFree(GLFWwindow* window, float dt, TransformComponent& transform) {
   bool currentRP = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
   glm::vec3 rot{0};
 
@@ -29,15 +29,17 @@ void KeyboardMovementController::moveFree(GLFWwindow* window, float dt, LveGameO
   }
   rightMousePressed = currentRP;
 
+  glm::vec3 rotation = transform.getRotation();
   if (glm::dot(rot, rot) > std::numeric_limits<float>::epsilon()) {
-    obj.transform.rotation += lookSpeed * dt * rot;
+    rotation += lookSpeed * dt * rot;
   }
 
-  obj.transform.rotation.x = glm::clamp(obj.transform.rotation.x, -1.5f, 1.5f);
-  obj.transform.rotation.y = glm::mod(obj.transform.rotation.y, glm::two_pi<float>());
+  rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+  rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
+  transform.setRotation(rotation);
 
-  float yaw = obj.transform.rotation.y;
-  float pitch = obj.transform.rotation.x;
+  float yaw = rotation.y;
+  float pitch = rotation.x;
   const glm::vec3 fwd{sin(yaw) * cos(pitch), -sin(pitch), cos(yaw) * cos(pitch)};
   const glm::vec3 right{cos(yaw), 0.f, -sin(yaw)};
   const glm::vec3 up{0.f, -1.f, 0.f};
@@ -54,19 +56,19 @@ void KeyboardMovementController::moveFree(GLFWwindow* window, float dt, LveGameO
     float mult = 1.f;
     if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) mult = 4.f;
     if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) mult = 0.2f;
-    obj.transform.translation += moveSpeed * dt * mult * glm::normalize(dir);
+    transform.setTranslation(transform.getTranslation() + moveSpeed * dt * mult * glm::normalize(dir));
   }
 }
 
-void KeyboardMovementController::handleScroll(GLFWwindow* window, double yOffset, LveGameObject& obj) {
-  float yaw = obj.transform.rotation.y;
-  float pitch = obj.transform.rotation.x;
+void KeyboardMovementController::handleScroll(GLFWwindow* window, double yOffset, TransformComponent& transform) {
+  float yaw = transform.getRotation().y;
+  float pitch = transform.getRotation().x;
   glm::vec3 fwd{sin(yaw) * cos(pitch), -sin(pitch), cos(yaw) * cos(pitch)};
   
   float mult = 1.f;
   if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) mult = 4.f;
   if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) mult = 0.2f;
-  obj.transform.translation += fwd * (static_cast<float>(yOffset) * scrollSpeed * mult);
+  transform.setTranslation(transform.getTranslation() + fwd * (static_cast<float>(yOffset) * scrollSpeed * mult));
 }
 
 }  // namespace lve
\ No newline at end of file
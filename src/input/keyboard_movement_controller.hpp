@@ -1,6 +1,6 @@
 #pragma once
 
-#include "scene/lve_game_object.hpp"
+#include "scene/lve_components.hpp"
 #include "core/lve_window.hpp"
 
 /**
@@ -25,8 +25,8 @@ class KeyboardMovementController {
     int lookDown = GLFW_KEY_DOWN;
   };
 
-  void moveFree(GLFWwindow* window, float dt, LveGameObject& gameObject);
-  void handleScroll(GLFWwindow* window, double yOffset, LveGameObject& gameObject);
+  void moveFree(GLFWwindow* window, float dt, TransformComponent& transform);
+  void handleScroll(GLFWwindow* window, double yOffset, TransformComponent& transform);
   void resetInput() noexcept { firstMouse = true; rightMousePressed = false; }
 
   KeyMappings keys{};
@@ -23,7 +23,8 @@ LveBuffer::LveBuffer(
     uint32_t instanceCount,
     VkBufferUsageFlags usageFlags,
     VkMemoryPropertyFlags memoryPropertyFlags,
-    VkDeviceSize minOffsetAlignment)
+    VkDeviceSize minOffsetAlignment,
+    LveMemoryTag tag)
     : lveDevice{device},
       instanceSize{instanceSize},
       instanceCount{instanceCount},
@@ -31,26 +32,24 @@ LveBuffer::LveBuffer(
       memoryPropertyFlags{memoryPropertyFlags} {
   alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
   bufferSize = alignmentSize * instanceCount;
-  device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+  device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation, tag);
 }
 
 LveBuffer::~LveBuffer() {
   unmap();
-  vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-  vkFreeMemory(lveDevice.device(), memory, nullptr);
+  lveDevice.destroyBuffer(buffer, allocation);
 }
 
+// host visible blocks are persistently mapped by the allocator, so map/unmap only hand out
+// or drop a pointer into this buffer's range
 VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-  assert(buffer && memory && "cannot map buffer before creation");
-  return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+  assert(buffer && allocation.isValid() && "cannot map buffer before creation");
+  if (!allocation.mapped) return VK_ERROR_MEMORY_MAP_FAILED;
+  mapped = static_cast<char *>(allocation.mapped) + offset;
+  return VK_SUCCESS;
 }
 
-void LveBuffer::unmap() {
-  if (mapped) {
-    vkUnmapMemory(lveDevice.device(), memory);
-    mapped = nullptr;
-  }
-}
+void LveBuffer::unmap() { mapped = nullptr; }
 
 void LveBuffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset) {
   assert(mapped && "cannot write to unmapped buffer");
@@ -63,21 +62,25 @@ void LveBuffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset
   }
 }
 
+void LveBuffer::upload(
+    LveUploadQueue &uploads, const void *data, VkDeviceSize size, VkDeviceSize offset, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+  if (size == 0) return;
+  if (!allocation.mapped) {
+    uploads.enqueueBufferUpload(buffer, data, size, offset, dstStage, dstAccess);
+    return;
+  }
+  // the range is not in use by the gpu yet, and host writes are made visible by the next queue submit
+  std::memcpy(static_cast<char *>(allocation.mapped) + offset, data, size);
+  flush(size, offset);
+}
+
 VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange range{};
-  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  range.memory = memory;
-  range.offset = offset;
-  range.size = size;
+  VkMappedMemoryRange range = lveDevice.allocator().mappedRange(allocation, size, offset);
   return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &range);
 }
 
 VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange range{};
-  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  range.memory = memory;
-  range.offset = offset;
-  range.size = size;
+  VkMappedMemoryRange range = lveDevice.allocator().mappedRange(allocation, size, offset);
   return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &range);
 }
 
@@ -19,7 +19,8 @@ class LveBuffer {
       uint32_t instanceCount,
       VkBufferUsageFlags usageFlags,
       VkMemoryPropertyFlags memoryPropertyFlags,
-      VkDeviceSize minOffsetAlignment = 1);
+      VkDeviceSize minOffsetAlignment = 1,
+      LveMemoryTag tag = LveMemoryTag::Other);
   ~LveBuffer();
 
   LveBuffer(const LveBuffer&) = delete;
@@ -29,6 +30,18 @@ class LveBuffer {
   void unmap();
 
   void writeToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+  /**
+   * fills size bytes at offset. host visible memory is written in place, anything else is
+   * staged through uploads. dstStage/dstAccess only matter for the staged path.
+   */
+  void upload(
+      LveUploadQueue& uploads,
+      const void* data,
+      VkDeviceSize size,
+      VkDeviceSize offset = 0,
+      VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+      VkAccessFlags dstAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
   VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const noexcept;
   VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -39,7 +52,9 @@ class LveBuffer {
   VkResult invalidateIndex(int index);
 
   VkBuffer getBuffer() const noexcept { return buffer; }
+  const LveAllocation& getAllocation() const noexcept { return allocation; }
   void* getMappedMemory() const noexcept { return mapped; }
+  bool isHostVisible() const noexcept { return allocation.mapped != nullptr; }
   uint32_t getInstanceCount() const noexcept { return instanceCount; }
   VkDeviceSize getInstanceSize() const noexcept { return instanceSize; }
   VkDeviceSize getAlignmentSize() const noexcept { return alignmentSize; }
@@ -53,7 +68,7 @@ class LveBuffer {
   LveDevice& lveDevice;
   void* mapped = nullptr;
   VkBuffer buffer = VK_NULL_HANDLE;
-  VkDeviceMemory memory = VK_NULL_HANDLE;
+  LveAllocation allocation{};
 
   VkDeviceSize bufferSize;
   uint32_t instanceCount;
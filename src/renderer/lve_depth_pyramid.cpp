@@ -0,0 +1,222 @@
+#include "renderer/lve_depth_pyramid.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+/**
+ * depth pyramid implementation.
+ * one dispatch per level, each reading the level above through a sampler and writing its own level
+ * through a storage view. the sets for levels past the first only change when the image is recreated.
+ */
+
+namespace lve {
+
+namespace {
+
+struct PyramidPushConstantData {
+  glm::ivec2 sourceSize;
+  glm::ivec2 destinationSize;
+};
+
+}  // namespace
+
+LveDepthPyramid::LveDepthPyramid(LveDevice &device, uint32_t framesInFlight) : lveDevice{device}, framesInFlight{framesInFlight} {
+  setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                  .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+                  .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+                  .build();
+  descriptorPool = LveDescriptorPool::Builder(lveDevice)
+                       .setMaxSets(MAX_LEVELS + framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_LEVELS + framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_LEVELS + framesInFlight)
+                       .build();
+
+  // texelFetch ignores filtering, the sampler only has to cover every level
+  VkSamplerCreateInfo sampInfo{};
+  sampInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sampInfo.magFilter = VK_FILTER_NEAREST;
+  sampInfo.minFilter = VK_FILTER_NEAREST;
+  sampInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sampInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampInfo.minLod = 0.0f;
+  sampInfo.maxLod = VK_LOD_CLAMP_NONE;
+  if (vkCreateSampler(lveDevice.device(), &sampInfo, nullptr, &sampler) != VK_SUCCESS) throw std::runtime_error("failed to create depth pyramid sampler");
+
+  createPipeline();
+}
+
+LveDepthPyramid::~LveDepthPyramid() {
+  destroyImage();
+  vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+  vkDestroySampler(lveDevice.device(), sampler, nullptr);
+}
+
+void LveDepthPyramid::createPipeline() {
+  VkPushConstantRange range{};
+  range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  range.offset = 0;
+  range.size = sizeof(PyramidPushConstantData);
+
+  VkDescriptorSetLayout layout = setLayout->getDescriptorSetLayout();
+  VkPipelineLayoutCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  info.setLayoutCount = 1;
+  info.pSetLayouts = &layout;
+  info.pushConstantRangeCount = 1;
+  info.pPushConstantRanges = &range;
+  if (vkCreatePipelineLayout(lveDevice.device(), &info, nullptr, &pipelineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create depth pyramid pipeline layout");
+
+  pipeline = std::make_unique<LveComputePipeline>(lveDevice, "shaders/depth_pyramid.comp.spv", pipelineLayout);
+}
+
+bool LveDepthPyramid::resize(VkExtent2D extent) {
+  if (extent.width == depthExtent.width && extent.height == depthExtent.height) return false;
+  if (image != VK_NULL_HANDLE) {
+    // only happens with the window size, the frames still reading the old image are waited for
+    vkDeviceWaitIdle(lveDevice.device());
+    destroyImage();
+  }
+  depthExtent = extent;
+  createImage();
+  return true;
+}
+
+void LveDepthPyramid::createImage() {
+  // rounding down keeps a level 0 texel within two depth texels either way
+  width = std::max(std::bit_floor(depthExtent.width), 1u);
+  height = std::max(std::bit_floor(depthExtent.height), 1u);
+  const uint32_t levelCount = std::min<uint32_t>(std::bit_width(std::max(width, height)), MAX_LEVELS);
+
+  VkImageCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  info.imageType = VK_IMAGE_TYPE_2D;
+  info.format = VK_FORMAT_R32_SFLOAT;
+  info.extent.width = width;
+  info.extent.height = height;
+  info.extent.depth = 1;
+  info.mipLevels = levelCount;
+  info.arrayLayers = 1;
+  info.samples = VK_SAMPLE_COUNT_1_BIT;
+  info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, allocation, LveMemoryTag::Attachment);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = VK_FORMAT_R32_SFLOAT;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = levelCount;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) throw std::runtime_error("failed to create depth pyramid view");
+
+  levelViews.resize(levelCount);
+  for (uint32_t level = 0; level < levelCount; level++) {
+    viewInfo.subresourceRange.baseMipLevel = level;
+    viewInfo.subresourceRange.levelCount = 1;
+    if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS) throw std::runtime_error("failed to create depth pyramid level view");
+  }
+
+  // level 0's source is written per build, the other levels read the one above
+  levelSets.assign(levelCount, VK_NULL_HANDLE);
+  for (uint32_t level = 1; level < levelCount; level++) {
+    VkDescriptorImageInfo sourceInfo{sampler, levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+    VkDescriptorImageInfo destinationInfo{VK_NULL_HANDLE, levelViews[level], VK_IMAGE_LAYOUT_GENERAL};
+    if (!LveDescriptorWriter(*setLayout, *descriptorPool).writeImage(0, &sourceInfo).writeImage(1, &destinationInfo).build(levelSets[level])) {
+      throw std::runtime_error("failed to allocate depth pyramid descriptor sets");
+    }
+  }
+  depthSets.assign(framesInFlight, VK_NULL_HANDLE);
+  VkDescriptorImageInfo destinationInfo{VK_NULL_HANDLE, levelViews[0], VK_IMAGE_LAYOUT_GENERAL};
+  for (auto &set : depthSets) {
+    if (!LveDescriptorWriter(*setLayout, *descriptorPool).writeImage(1, &destinationInfo).build(set)) {
+      throw std::runtime_error("failed to allocate depth pyramid descriptor sets");
+    }
+  }
+
+  VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1};
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+  lveDevice.endSingleTimeCommands(commandBuffer);
+}
+
+void LveDepthPyramid::destroyImage() {
+  if (image == VK_NULL_HANDLE) return;
+  descriptorPool->resetPool();
+  levelSets.clear();
+  depthSets.clear();
+  for (auto levelView : levelViews) vkDestroyImageView(lveDevice.device(), levelView, nullptr);
+  levelViews.clear();
+  vkDestroyImageView(lveDevice.device(), view, nullptr);
+  view = VK_NULL_HANDLE;
+  lveDevice.destroyImage(image, allocation);
+  image = VK_NULL_HANDLE;
+}
+
+void LveDepthPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, VkImageView depthView) {
+  // the slot's last build has finished once its frame context is handed out again
+  VkDescriptorImageInfo depthInfo{sampler, depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  LveDescriptorWriter(*setLayout, *descriptorPool).writeImage(0, &depthInfo).overwrite(depthSets[frameIndex]);
+
+  // earlier readers of the pyramid have to finish before level 0 is overwritten
+  VkMemoryBarrier readBarrier{};
+  readBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  readBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  readBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readBarrier, 0, nullptr, 0, nullptr);
+
+  pipeline->bind(commandBuffer);
+  glm::ivec2 sourceSize{static_cast<int>(depthExtent.width), static_cast<int>(depthExtent.height)};
+  for (uint32_t level = 0; level < getLevelCount(); level++) {
+    VkDescriptorSet set = level == 0 ? depthSets[frameIndex] : levelSets[level];
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+
+    PyramidPushConstantData push{};
+    push.sourceSize = sourceSize;
+    push.destinationSize = {static_cast<int>(std::max(width >> level, 1u)), static_cast<int>(std::max(height >> level, 1u))};
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidPushConstantData), &push);
+    vkCmdDispatch(
+        commandBuffer,
+        (push.destinationSize.x + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+        (push.destinationSize.y + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+        1);
+    sourceSize = push.destinationSize;
+
+    // the next level, and the culling after the last one, read what was just written
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "core/lve_device.hpp"
+#include "renderer/lve_descriptors.hpp"
+#include "renderer/lve_pipeline.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * hierarchical depth (hi-z) pyramid.
+ * a compute pass reduces the depth buffer into an r32 mip chain where every texel holds the farthest
+ * depth of the area it covers, so a box can be tested for occlusion with a few fetches at the level
+ * where its screen rect spans at most two texels. level 0 is the depth extent rounded down to powers
+ * of two, which keeps every further level an exact halving. the image always stays in general layout.
+ */
+
+namespace lve {
+
+class LveDepthPyramid {
+ public:
+  LveDepthPyramid(LveDevice &device, uint32_t framesInFlight);
+  ~LveDepthPyramid();
+
+  LveDepthPyramid(const LveDepthPyramid &) = delete;
+  LveDepthPyramid &operator=(const LveDepthPyramid &) = delete;
+
+  /**
+   * fits the pyramid to a depth buffer of depthExtent. a new size waits for the device to go idle
+   * before the old image is released; returns whether the image was recreated.
+   */
+  bool resize(VkExtent2D depthExtent);
+
+  /**
+   * reduces depthView, in shader read only layout, into every level. recorded outside of any render
+   * pass; frameIndex picks the descriptor set that reads the depth buffer.
+   */
+  void build(VkCommandBuffer commandBuffer, int frameIndex, VkImageView depthView);
+
+  // every level, for texelFetch from a sampler2D
+  VkDescriptorImageInfo descriptorInfo() const noexcept { return {sampler, view, VK_IMAGE_LAYOUT_GENERAL}; }
+  uint32_t getWidth() const noexcept { return width; }
+  uint32_t getHeight() const noexcept { return height; }
+  uint32_t getLevelCount() const noexcept { return static_cast<uint32_t>(levelViews.size()); }
+
+ private:
+  static constexpr uint32_t MAX_LEVELS = 16;
+  static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+  void createPipeline();
+  void createImage();
+  void destroyImage();
+
+  LveDevice &lveDevice;
+  uint32_t framesInFlight;
+  VkSampler sampler = VK_NULL_HANDLE;
+  std::unique_ptr<LveDescriptorSetLayout> setLayout;
+  std::unique_ptr<LveDescriptorPool> descriptorPool;
+  VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+  std::unique_ptr<LveComputePipeline> pipeline;
+
+  VkExtent2D depthExtent{0, 0};
+  uint32_t width = 0;
+  uint32_t height = 0;
+  VkImage image = VK_NULL_HANDLE;
+  LveAllocation allocation{};
+  VkImageView view = VK_NULL_HANDLE;
+  std::vector<VkImageView> levelViews;
+  // level i > 0 reduces level i - 1 into level i; level 0 reads the depth buffer through a set per frame slot
+  std::vector<VkDescriptorSet> levelSets;
+  std::vector<VkDescriptorSet> depthSets;
+};
+
+}  // namespace lve
@@ -0,0 +1,43 @@
+#include "renderer/lve_draw_list.hpp"
+
+#include <algorithm>
+#include <array>
+
+/**
+ * draw list implementation.
+ * all eight digit histograms are built in one read of the keys, then each non trivial digit
+ * scatters between the packet array and a scratch array kept across frames.
+ */
+
+namespace lve {
+
+void LveDrawList::sort() {
+  const size_t count = packets.size();
+  // below this a comparison sort wins over eight histogram passes
+  if (count < 64) {
+    std::stable_sort(packets.begin(), packets.end(), [](const LveDrawPacket &a, const LveDrawPacket &b) { return a.key < b.key; });
+    return;
+  }
+
+  std::array<std::array<uint32_t, 256>, 8> histograms{};
+  for (const auto &packet : packets) {
+    for (uint32_t digit = 0; digit < 8; digit++) histograms[digit][(packet.key >> (digit * 8)) & 0xff]++;
+  }
+
+  scratch.resize(count);
+  for (uint32_t digit = 0; digit < 8; digit++) {
+    auto &histogram = histograms[digit];
+    if (histogram[(packets[0].key >> (digit * 8)) & 0xff] == count) continue;
+
+    uint32_t offset = 0;
+    for (auto &bucket : histogram) {
+      uint32_t n = bucket;
+      bucket = offset;
+      offset += n;
+    }
+    for (const auto &packet : packets) scratch[histogram[(packet.key >> (digit * 8)) & 0xff]++] = packet;
+    packets.swap(scratch);
+  }
+}
+
+}  // namespace lve
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * sortable list of draw packets.
+ * a render system emits one packet per draw with a 64 bit key ordered by the state it needs, most
+ * expensive change first, and a radix sort brings draws sharing state next to each other so the
+ * submit loop only rebinds what actually changes. the payload is the system's own draw index.
+ */
+
+namespace lve {
+
+struct LveDrawPacket {
+  uint64_t key;
+  uint32_t payload;
+};
+
+/**
+ * key layout from the top bit down:
+ *   pass 4 | pipeline 8 | material 16 | buffers 8 | model 16 | depth 12
+ * material and model are dense per frame indices from the draw list, so every material and model
+ * keeps one contiguous run however many objects share it. buffers is a hashed handle: a collision
+ * only lets the models of two buffers alternate, which costs a rebind per model and never splits a
+ * model's run. depth is the [0, 1] clip depth, so opaque draws run front to back within a state bucket.
+ */
+struct LveSortKey {
+  static constexpr uint32_t PASS_BITS = 4;
+  static constexpr uint32_t PIPELINE_BITS = 8;
+  static constexpr uint32_t MATERIAL_BITS = 16;
+  static constexpr uint32_t BUFFERS_BITS = 8;
+  static constexpr uint32_t MODEL_BITS = 16;
+  static constexpr uint32_t DEPTH_BITS = 12;
+
+  /** folds a handle or pointer down to its top bits with fibonacci hashing. */
+  static constexpr uint64_t hashBits(uint64_t value, uint32_t bits) noexcept { return (value * 0x9E3779B97F4A7C15ull) >> (64 - bits); }
+
+  // non finite and negative depths, as from a point behind the camera, sort first
+  static uint64_t quantizeDepth(float depth) noexcept {
+    constexpr float MAX_DEPTH = static_cast<float>((1u << DEPTH_BITS) - 1);
+    if (!(depth > 0.f)) return 0;
+    float clamped = depth > 1.f ? 1.f : depth;
+    return static_cast<uint64_t>(clamped * MAX_DEPTH);
+  }
+
+  static constexpr uint64_t make(
+      uint32_t pass, uint32_t pipeline, uint32_t materialIndex, uint64_t buffersId, uint32_t modelIndex, uint64_t depth) noexcept {
+    return (static_cast<uint64_t>(pass & ((1u << PASS_BITS) - 1)) << (64 - PASS_BITS)) |
+           (static_cast<uint64_t>(pipeline & ((1u << PIPELINE_BITS) - 1)) << (MATERIAL_BITS + BUFFERS_BITS + MODEL_BITS + DEPTH_BITS)) |
+           (static_cast<uint64_t>(materialIndex & ((1u << MATERIAL_BITS) - 1)) << (BUFFERS_BITS + MODEL_BITS + DEPTH_BITS)) |
+           (hashBits(buffersId, BUFFERS_BITS) << (MODEL_BITS + DEPTH_BITS)) |
+           (static_cast<uint64_t>(modelIndex & ((1u << MODEL_BITS) - 1)) << DEPTH_BITS) |
+           depth;
+  }
+};
+
+class LveDrawList {
+ public:
+  void clear() noexcept {
+    packets.clear();
+    materialIndices.clear();
+    modelIndices.clear();
+  }
+  void reserve(size_t count) { packets.reserve(count); }
+  void push(uint64_t key, uint32_t payload) { packets.push_back({key, payload}); }
+
+  // dense indices in first seen order since the last clear(), for the material and model key fields
+  uint32_t materialIndex(uint64_t handle) { return indexOf(materialIndices, handle); }
+  uint32_t modelIndex(uint64_t handle) { return indexOf(modelIndices, handle); }
+
+  /** stable lsd radix sort on the key, 8 bits per pass; passes where every key shares the digit are skipped. */
+  void sort();
+
+  uint32_t size() const noexcept { return static_cast<uint32_t>(packets.size()); }
+  bool empty() const noexcept { return packets.empty(); }
+  const LveDrawPacket &operator[](uint32_t i) const noexcept { return packets[i]; }
+  const LveDrawPacket *begin() const noexcept { return packets.data(); }
+  const LveDrawPacket *end() const noexcept { return packets.data() + packets.size(); }
+
+ private:
+  static uint32_t indexOf(std::unordered_map<uint64_t, uint32_t> &indices, uint64_t handle) {
+    return indices.try_emplace(handle, static_cast<uint32_t>(indices.size())).first->second;
+  }
+
+  std::vector<LveDrawPacket> packets;
+  std::vector<LveDrawPacket> scratch;
+  // cleared, not freed, so their buckets are reused frame to frame
+  std::unordered_map<uint64_t, uint32_t> materialIndices;
+  std::unordered_map<uint64_t, uint32_t> modelIndices;
+};
+
+}  // namespace lve
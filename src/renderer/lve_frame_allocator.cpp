@@ -0,0 +1,87 @@
+#include "renderer/lve_frame_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+/**
+ * frame allocator implementation.
+ * each buffer is padded past its capacity by the larger descriptor range, so a slice near
+ * the end can still be bound with a fixed-range dynamic descriptor.
+ */
+
+namespace lve {
+
+LveFrameAllocator::LveFrameAllocator(LveDevice &device, uint32_t framesInFlight, VkDeviceSize capacity) : lveDevice{device} {
+  const auto &limits = lveDevice.properties.limits;
+  alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+  uniformRange = std::min<VkDeviceSize>(limits.maxUniformBufferRange, 64 * 1024);
+
+  setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                  .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                  .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                  .build();
+  descriptorPool = LveDescriptorPool::Builder(lveDevice)
+                       .setMaxSets(framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, framesInFlight)
+                       .build();
+
+  buffers.resize(framesInFlight);
+  descriptorSets.resize(framesInFlight, VK_NULL_HANDLE);
+  capacities.resize(framesInFlight);
+  for (uint32_t i = 0; i < framesInFlight; i++) createBuffer(i, capacity);
+}
+
+LveFrameAllocator::~LveFrameAllocator() = default;
+
+void LveFrameAllocator::createBuffer(uint32_t slot, VkDeviceSize capacity) {
+  VkDeviceSize padding = std::max(uniformRange, STORAGE_RANGE);
+  buffers[slot] = std::make_unique<LveBuffer>(
+      lveDevice,
+      capacity + padding,
+      1,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      lveDevice.dynamicMemoryProperties(),
+      1,
+      LveMemoryTag::Uniform);
+  buffers[slot]->map();
+  capacities[slot] = capacity;
+
+  auto uniformInfo = buffers[slot]->descriptorInfo(uniformRange, 0);
+  auto storageInfo = buffers[slot]->descriptorInfo(STORAGE_RANGE, 0);
+  LveDescriptorWriter writer{*setLayout, *descriptorPool};
+  writer.writeBuffer(0, &uniformInfo).writeBuffer(1, &storageInfo);
+  if (descriptorSets[slot] == VK_NULL_HANDLE) {
+    if (!writer.build(descriptorSets[slot])) throw std::runtime_error("failed to allocate frame allocator descriptor set");
+  } else {
+    writer.overwrite(descriptorSets[slot]);
+  }
+}
+
+void LveFrameAllocator::beginFrame(int frameIndex) {
+  currentFrame = frameIndex;
+  head.store(0, std::memory_order_relaxed);
+}
+
+void LveFrameAllocator::reserve(VkDeviceSize size, uint32_t count) {
+  assert(head.load(std::memory_order_relaxed) == 0 && "reserve before the frame's first allocation");
+  const VkDeviceSize needed = size + static_cast<VkDeviceSize>(count) * alignment;
+  if (needed <= capacities[currentFrame]) return;
+  // the slot's last frame has finished, so its buffer can go; grow geometrically to settle quickly
+  createBuffer(static_cast<uint32_t>(currentFrame), std::max(needed, 2 * capacities[currentFrame]));
+}
+
+LveFrameAllocator::Slice LveFrameAllocator::allocate(VkDeviceSize size) {
+  VkDeviceSize alignedSize = (size + alignment - 1) / alignment * alignment;
+  VkDeviceSize offset = head.fetch_add(alignedSize, std::memory_order_relaxed);
+  if (offset + alignedSize > capacities[currentFrame]) throw std::runtime_error("frame allocator out of memory");
+
+  Slice slice{};
+  slice.data = static_cast<char *>(buffers[currentFrame]->getMappedMemory()) + offset;
+  slice.offset = static_cast<uint32_t>(offset);
+  slice.size = size;
+  return slice;
+}
+
+}  // namespace lve
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "core/lve_device.hpp"
+#include "renderer/lve_buffer.hpp"
+#include "renderer/lve_descriptors.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * per-frame linear allocator for transient shader data.
+ * hands out aligned slices of a persistently mapped buffer per frame in flight, read through
+ * one descriptor set with a dynamic uniform (binding 0) and a dynamic storage (binding 1) buffer.
+ */
+
+namespace lve {
+
+class LveFrameAllocator {
+ public:
+  static constexpr VkDeviceSize DEFAULT_CAPACITY = 4ull * 1024 * 1024;
+  static constexpr VkDeviceSize STORAGE_RANGE = 1ull * 1024 * 1024;
+
+  /** a slice of this frame's buffer. offset is what goes into the dynamic offset array. */
+  struct Slice {
+    void *data = nullptr;
+    uint32_t offset = 0;
+    VkDeviceSize size = 0;
+  };
+
+  LveFrameAllocator(LveDevice &device, uint32_t framesInFlight, VkDeviceSize capacity = DEFAULT_CAPACITY);
+  ~LveFrameAllocator();
+
+  LveFrameAllocator(const LveFrameAllocator &) = delete;
+  LveFrameAllocator &operator=(const LveFrameAllocator &) = delete;
+
+  /**
+   * rewinds the slot of frameIndex. only call once the renderer has handed out that frame context again.
+   */
+  void beginFrame(int frameIndex);
+
+  /**
+   * grows the current frame's buffer, if needed, so count allocations totalling size bytes fit whatever
+   * their alignment padding. the slot's buffer and set are replaced, so call it after beginFrame() and
+   * before anything of this frame is allocated or bound.
+   */
+  void reserve(VkDeviceSize size, uint32_t count);
+
+  /**
+   * bumps the current frame's head by size rounded up to the descriptor offset alignment.
+   * lock free, so several recording threads can allocate at once.
+   */
+  Slice allocate(VkDeviceSize size);
+
+  template <typename T>
+  Slice push(const T &value) {
+    auto slice = allocate(sizeof(T));
+    std::memcpy(slice.data, &value, sizeof(T));
+    return slice;
+  }
+
+  VkDescriptorSetLayout getSetLayout() const noexcept { return setLayout->getDescriptorSetLayout(); }
+  VkDescriptorSet getDescriptorSet() const noexcept { return descriptorSets[currentFrame]; }
+  VkDeviceSize getUniformRange() const noexcept { return uniformRange; }
+  VkDeviceSize getStorageRange() const noexcept { return STORAGE_RANGE; }
+  VkDeviceSize getCapacity() const noexcept { return capacities[currentFrame]; }
+  VkDeviceSize getUsedBytes() const noexcept { return head.load(std::memory_order_relaxed); }
+
+ private:
+  void createBuffer(uint32_t slot, VkDeviceSize capacity);
+
+  LveDevice &lveDevice;
+  VkDeviceSize alignment;
+  VkDeviceSize uniformRange;
+  std::vector<VkDeviceSize> capacities;
+
+  std::vector<std::unique_ptr<LveBuffer>> buffers;
+  std::unique_ptr<LveDescriptorSetLayout> setLayout;
+  std::unique_ptr<LveDescriptorPool> descriptorPool;
+  std::vector<VkDescriptorSet> descriptorSets;
+
+  int currentFrame = 0;
+  std::atomic<VkDeviceSize> head{0};
+};
+
+}  // namespace lve
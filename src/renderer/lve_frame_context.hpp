@@ -0,0 +1,42 @@
+#pragma once
+
+#include "renderer/lve_buffer.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * everything one frame in flight owns.
+ * the renderer keeps one context per possible frame in flight and hands out the next one once the
+ * frame timeline shows the gpu finished the work last recorded with it. resources that used to be
+ * arrays indexed by frame live here, so the frame count is set in one place and can change at runtime.
+ */
+
+namespace lve {
+
+struct LveFrameContext {
+  /** a command pool reset every time the frame comes around, one per recording thread. */
+  struct CommandPool {
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> buffers;
+    uint32_t used = 0;
+  };
+
+  uint32_t index = 0;
+  // timeline value signalled by the last submission recorded with this context, 0 before first use
+  uint64_t submitValue = 0;
+
+  VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+  // secondaries per thread, the last pool belongs to the main thread
+  std::vector<CommandPool> commandPools;
+  VkSemaphore imageAvailable = VK_NULL_HANDLE;
+
+  // shader data rewritten every frame, created by the app and its systems
+  std::unique_ptr<LveBuffer> uboBuffer;
+  VkDescriptorSet globalDescriptorSet = VK_NULL_HANDLE;
+  std::unique_ptr<LveBuffer> im3dVertexBuffer;
+};
+
+}  // namespace lve
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "renderer/lve_frame_allocator.hpp"
+#include "renderer/lve_renderer.hpp"
 #include "scene/lve_camera.hpp"
-#include "scene/lve_game_object.hpp"
+#include "scene/lve_scene.hpp"
 
 #include <vulkan/vulkan.h>
 
@@ -29,13 +31,18 @@ struct GlobalUbo {
   int numLights;
 };
 
+// commandBuffer is the primary inside a render pass; systems either record into a secondary of
+// their own via renderer or are handed one (in commandBuffer) by whoever drives the pass
 struct FrameInfo {
   int frameIndex;
   float frameTime;
   VkCommandBuffer commandBuffer;
   LveCamera &camera;
   VkDescriptorSet globalDescriptorSet;
-  LveGameObject::Map &gameObjects;
+  LveScene &scene;
+  LveFrameAllocator &frameAllocator;
+  LveRenderer &renderer;
+  LveFrameContext &frameContext;
 };
 
 }  // namespace lve
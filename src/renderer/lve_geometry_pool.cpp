@@ -0,0 +1,135 @@
+#include "renderer/lve_geometry_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+/**
+ * geometry pool implementation.
+ * spans are kept sorted by offset so neighbours can be merged on free.
+ */
+
+namespace lve {
+
+bool LveGeometryPool::FreeList::allocate(uint32_t count, uint32_t &offset) {
+  if (count == 0) {
+    offset = 0;
+    return true;
+  }
+  for (size_t i = 0; i < spans.size(); i++) {
+    if (spans[i].count < count) continue;
+    offset = spans[i].offset;
+    spans[i].offset += count;
+    spans[i].count -= count;
+    if (spans[i].count == 0) spans.erase(spans.begin() + i);
+    return true;
+  }
+  return false;
+}
+
+void LveGeometryPool::FreeList::free(uint32_t offset, uint32_t count) {
+  if (count == 0) return;
+  auto it = std::lower_bound(spans.begin(), spans.end(), offset, [](const Span &s, uint32_t o) { return s.offset < o; });
+  it = spans.insert(it, {offset, count});
+
+  auto next = it + 1;
+  if (next != spans.end() && it->offset + it->count == next->offset) {
+    it->count += next->count;
+    spans.erase(next);
+  }
+  if (it != spans.begin()) {
+    auto prev = it - 1;
+    if (prev->offset + prev->count == it->offset) {
+      prev->count += it->count;
+      spans.erase(it);
+    }
+  }
+}
+
+LveGeometryPool::LveGeometryPool(LveDevice &device, uint32_t vertexStride, uint32_t pageVertices, uint32_t pageIndices)
+    : lveDevice{device}, vertexStride{vertexStride}, pageVertices{pageVertices}, pageIndices{pageIndices} {}
+
+LveGeometryPool::~LveGeometryPool() = default;
+
+void LveGeometryPool::createPage(uint32_t vertexCapacity, uint32_t indexCapacity) {
+  Page page{};
+  page.vertexBuffer = std::make_unique<LveBuffer>(
+      lveDevice, vertexStride, vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, lveDevice.uploadMemoryProperties(), 1, LveMemoryTag::Mesh);
+  page.indexBuffer = std::make_unique<LveBuffer>(
+      lveDevice, sizeof(uint32_t), std::max(indexCapacity, 1u), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, lveDevice.uploadMemoryProperties(), 1, LveMemoryTag::Mesh);
+  page.vertexSpace.spans.push_back({0, vertexCapacity});
+  page.indexSpace.spans.push_back({0, indexCapacity});
+  pages.push_back(std::move(page));
+}
+
+LveGeometryPool::Range LveGeometryPool::allocate(const void *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount) {
+  assert(vertexCount > 0 && "cannot pool an empty mesh");
+
+  Range range{};
+  range.vertexCount = vertexCount;
+  range.indexCount = indexCount;
+
+  bool placed = false;
+  for (uint32_t p = 0; p < pages.size() && !placed; p++) {
+    auto &page = pages[p];
+    if (!page.vertexSpace.allocate(vertexCount, range.vertexOffset)) continue;
+    if (!page.indexSpace.allocate(indexCount, range.firstIndex)) {
+      page.vertexSpace.free(range.vertexOffset, vertexCount);
+      continue;
+    }
+    range.page = p;
+    placed = true;
+  }
+
+  if (!placed) {
+    createPage(std::max(vertexCount, pageVertices), std::max(indexCount, pageIndices));
+    range.page = static_cast<uint32_t>(pages.size() - 1);
+    pages.back().vertexSpace.allocate(vertexCount, range.vertexOffset);
+    pages.back().indexSpace.allocate(indexCount, range.firstIndex);
+  }
+
+  auto &page = pages[range.page];
+  auto &uploads = lveDevice.streamingQueue();
+  page.vertexBuffer->upload(
+      uploads,
+      vertices,
+      static_cast<VkDeviceSize>(vertexCount) * vertexStride,
+      static_cast<VkDeviceSize>(range.vertexOffset) * vertexStride,
+      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+      VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+  if (indexCount > 0) {
+    page.indexBuffer->upload(
+        uploads,
+        indices,
+        static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t),
+        static_cast<VkDeviceSize>(range.firstIndex) * sizeof(uint32_t),
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        VK_ACCESS_INDEX_READ_BIT);
+  }
+  return range;
+}
+
+void LveGeometryPool::free(const Range &range) { pendingFrees.push_back({currentFrame, range}); }
+
+void LveGeometryPool::beginFrame(uint64_t frameNumber, uint64_t completedFrame) {
+  currentFrame = frameNumber;
+  while (!pendingFrees.empty() && pendingFrees.front().frameNumber <= completedFrame) {
+    release(pendingFrees.front().range);
+    pendingFrees.pop_front();
+  }
+}
+
+void LveGeometryPool::release(const Range &range) {
+  auto &page = pages[range.page];
+  page.vertexSpace.free(range.vertexOffset, range.vertexCount);
+  page.indexSpace.free(range.firstIndex, range.indexCount);
+}
+
+void LveGeometryPool::bind(LveCommandRecorder &recorder, uint32_t page) const {
+  VkBuffer buffers[] = {pages[page].vertexBuffer->getBuffer()};
+  VkDeviceSize offsets[] = {0};
+  recorder.bindVertexBuffers(0, 1, buffers, offsets);
+  recorder.bindIndexBuffer(pages[page].indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+}
+
+}  // namespace lve
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "core/lve_device.hpp"
+#include "renderer/lve_buffer.hpp"
+#include "renderer/lve_render_stats.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * shared vertex/index storage for meshes.
+ * packs geometry into a few large device local pages so draws only differ by
+ * vertexOffset/firstIndex and consecutive draws from one page share a single bind.
+ */
+
+namespace lve {
+
+class LveGeometryPool {
+ public:
+  static constexpr uint32_t DEFAULT_PAGE_VERTICES = 1u << 20;
+  static constexpr uint32_t DEFAULT_PAGE_INDICES = 1u << 22;
+
+  /** location of one mesh inside the pool, in elements rather than bytes. */
+  struct Range {
+    uint32_t page = 0;
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+  };
+
+  LveGeometryPool(
+      LveDevice &device,
+      uint32_t vertexStride,
+      uint32_t pageVertices = DEFAULT_PAGE_VERTICES,
+      uint32_t pageIndices = DEFAULT_PAGE_INDICES);
+  ~LveGeometryPool();
+
+  LveGeometryPool(const LveGeometryPool &) = delete;
+  LveGeometryPool &operator=(const LveGeometryPool &) = delete;
+
+  /**
+   * reserves space for a mesh and queues its upload on the streaming queue.
+   * meshes larger than a page get a page of their own.
+   */
+  Range allocate(const void *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount);
+
+  /**
+   * returns a mesh's ranges to the pool once the frame being recorded, and every frame before it, has retired.
+   */
+  void free(const Range &range);
+
+  /**
+   * frameNumber is the frame timeline value about to be recorded, completedFrame the last value the
+   * gpu reached. releases every range freed during a frame that has completed.
+   */
+  void beginFrame(uint64_t frameNumber, uint64_t completedFrame);
+
+  void bind(LveCommandRecorder &recorder, uint32_t page) const;
+
+  uint32_t getPageCount() const noexcept { return static_cast<uint32_t>(pages.size()); }
+  uint32_t getVertexStride() const noexcept { return vertexStride; }
+  VkBuffer getVertexBuffer(uint32_t page) const noexcept { return pages[page].vertexBuffer->getBuffer(); }
+  VkBuffer getIndexBuffer(uint32_t page) const noexcept { return pages[page].indexBuffer->getBuffer(); }
+
+ private:
+  /** first-fit element range allocator with coalescing, one per page and buffer. */
+  struct FreeList {
+    struct Span {
+      uint32_t offset;
+      uint32_t count;
+    };
+    std::vector<Span> spans;
+
+    bool allocate(uint32_t count, uint32_t &offset);
+    void free(uint32_t offset, uint32_t count);
+  };
+
+  struct Page {
+    std::unique_ptr<LveBuffer> vertexBuffer;
+    std::unique_ptr<LveBuffer> indexBuffer;
+    FreeList vertexSpace;
+    FreeList indexSpace;
+  };
+
+  void createPage(uint32_t vertexCapacity, uint32_t indexCapacity);
+  void release(const Range &range);
+
+  LveDevice &lveDevice;
+  uint32_t vertexStride;
+  uint32_t pageVertices;
+  uint32_t pageIndices;
+
+  std::vector<Page> pages;
+  struct PendingFree {
+    uint64_t frameNumber;
+    Range range;
+  };
+  // in frame order, so retired entries are always at the front
+  std::deque<PendingFree> pendingFrees;
+  uint64_t currentFrame = 0;
+};
+
+}  // namespace lve
@@ -8,9 +8,24 @@
 #include <tinygltf/json.hpp>
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cassert>
 #include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// start of element i of a float accessor, honouring an interleaved view's stride
+const float* accessorElement(const tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t i) {
+  const auto& view = model.bufferViews[accessor.bufferView];
+  const int stride = accessor.ByteStride(view);
+  return reinterpret_cast<const float*>(&model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset + i * stride]);
+}
+
+}  // namespace
 
 /**
  * gltf 2.0 loader implementation.
@@ -19,7 +34,7 @@
 
 namespace lve {
 
-LveGltfModel::LveGltfModel(LveDevice& device, const std::string& filepath) : lveDevice{device} {
+LveGltfModel::LveGltfModel(LveDevice& device, const std::string& filepath, LveGeometryPool* pool) : lveDevice{device}, geometryPool{pool} {
   loadFromFile(filepath);
 }
 
@@ -41,13 +56,15 @@ void LveGltfModel::loadFromFile(const std::string& filepath) {
   loadMaterials(input);
   loadNodes(input);
 
-  vertexBuffer = std::make_unique<LveBuffer>(lveDevice, sizeof(vertices[0]), static_cast<uint32_t>(vertices.size()), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-  vertexBuffer->map();
-  vertexBuffer->writeToBuffer(vertices.data());
+  // pooled meshes already live in their scene models, the whole-file buffers only serve bind() and draw()
+  if (geometryPool) return;
 
-  indexBuffer = std::make_unique<LveBuffer>(lveDevice, sizeof(indices[0]), static_cast<uint32_t>(indices.size()), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-  indexBuffer->map();
-  indexBuffer->writeToBuffer(indices.data());
+  // device local + host visible only exists on some hardware, let the buffer fall back to staging
+  vertexBuffer = std::make_unique<LveBuffer>(lveDevice, sizeof(vertices[0]), static_cast<uint32_t>(vertices.size()), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, lveDevice.uploadMemoryProperties(), 1, LveMemoryTag::Mesh);
+  vertexBuffer->upload(lveDevice.streamingQueue(), vertices.data(), vertexBuffer->getBufferSize(), 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+  indexBuffer = std::make_unique<LveBuffer>(lveDevice, sizeof(indices[0]), static_cast<uint32_t>(indices.size()), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, lveDevice.uploadMemoryProperties(), 1, LveMemoryTag::Mesh);
+  indexBuffer->upload(lveDevice.streamingQueue(), indices.data(), indexBuffer->getBufferSize(), 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 }
 
 void LveGltfModel::loadMaterials(tinygltf::Model& input) {
@@ -72,37 +89,61 @@ void LveGltfModel::loadNodes(tinygltf::Model& input) {
 std::unique_ptr<LveGltfModel::Node> LveGltfModel::loadNode(Node* parent, const tinygltf::Node& inputNode, uint32_t nodeIndex, const tinygltf::Model& inputModel) {
   auto node = std::make_unique<Node>();
   node->parent = parent;
+  node->name = inputNode.name;
   if (inputNode.matrix.size() == 16) {
     node->matrix = glm::make_mat4(inputNode.matrix.data());
   } else {
+    // most exporters write trs instead of a matrix, composed as t * r * s
     node->matrix = glm::mat4(1.0f);
+    if (inputNode.translation.size() == 3) node->matrix = glm::translate(node->matrix, glm::vec3(glm::make_vec3(inputNode.translation.data())));
+    if (inputNode.rotation.size() == 4) {
+      const auto& r = inputNode.rotation;
+      glm::quat q{static_cast<float>(r[3]), static_cast<float>(r[0]), static_cast<float>(r[1]), static_cast<float>(r[2])};
+      node->matrix = node->matrix * glm::mat4_cast(q);
+    }
+    if (inputNode.scale.size() == 3) node->matrix = glm::scale(node->matrix, glm::vec3(glm::make_vec3(inputNode.scale.data())));
   }
 
   if (inputNode.mesh > -1) {
     const auto& mesh = inputModel.meshes[inputNode.mesh];
     auto lveMesh = std::make_unique<Mesh>();
+    const uint32_t meshIndexStart = static_cast<uint32_t>(indices.size());
+    const uint32_t meshVertexStart = static_cast<uint32_t>(vertices.size());
     for (const auto& primitive : mesh.primitives) {
       uint32_t idxStart = static_cast<uint32_t>(indices.size());
       uint32_t vStart = static_cast<uint32_t>(vertices.size());
 
       const auto& posAccessor = inputModel.accessors[primitive.attributes.at("POSITION")];
-      const auto& posView = inputModel.bufferViews[posAccessor.bufferView];
-      const float* bufferPos = reinterpret_cast<const float*>(&(inputModel.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-      
+      auto normalIt = primitive.attributes.find("NORMAL");
+      auto uvIt = primitive.attributes.find("TEXCOORD_0");
       for (size_t v = 0; v < posAccessor.count; v++) {
         Vertex vertex;
-        vertex.pos = glm::make_vec3(&bufferPos[v * 3]);
+        vertex.pos = glm::make_vec3(accessorElement(inputModel, posAccessor, v));
         vertex.color = glm::vec4(1.0f);
         vertex.normal = glm::vec3(0.0f);
         vertex.uv = glm::vec2(0.0f);
+        if (normalIt != primitive.attributes.end()) vertex.normal = glm::make_vec3(accessorElement(inputModel, inputModel.accessors[normalIt->second], v));
+        if (uvIt != primitive.attributes.end()) {
+          const float* uv = accessorElement(inputModel, inputModel.accessors[uvIt->second], v);
+          vertex.uv = glm::vec2(uv[0], uv[1]);
+        }
         vertices.push_back(vertex);
       }
 
+      // exporters pick the smallest index type that fits
       const auto& idxAccessor = inputModel.accessors[primitive.indices];
       const auto& idxView = inputModel.bufferViews[idxAccessor.bufferView];
-      const uint32_t* bufferIdx = reinterpret_cast<const uint32_t*>(&(inputModel.buffers[idxView.buffer].data[idxAccessor.byteOffset + idxView.byteOffset]));
-      
-      for (size_t i = 0; i < idxAccessor.count; i++) indices.push_back(bufferIdx[i] + vStart);
+      const unsigned char* bufferIdx = &inputModel.buffers[idxView.buffer].data[idxAccessor.byteOffset + idxView.byteOffset];
+      for (size_t i = 0; i < idxAccessor.count; i++) {
+        uint32_t index = 0;
+        switch (idxAccessor.componentType) {
+          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: index = reinterpret_cast<const uint32_t*>(bufferIdx)[i]; break;
+          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: index = reinterpret_cast<const uint16_t*>(bufferIdx)[i]; break;
+          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: index = bufferIdx[i]; break;
+          default: throw std::runtime_error("unsupported gltf index type");
+        }
+        indices.push_back(index + vStart);
+      }
 
       Primitive prim;
       prim.firstIndex = idxStart;
@@ -110,6 +151,17 @@ std::unique_ptr<LveGltfModel::Node> LveGltfModel::loadNode(Node* parent, const t
       prim.materialIndex = primitive.material;
       lveMesh->primitives.push_back(prim);
     }
+
+    // the scene draws meshes as LveModel, so the primitives are copied into one in its vertex layout
+    LveModel::Builder builder{};
+    builder.vertices.reserve(vertices.size() - meshVertexStart);
+    for (size_t v = meshVertexStart; v < vertices.size(); v++) {
+      builder.vertices.push_back({vertices[v].pos, glm::vec3(vertices[v].color), vertices[v].normal, vertices[v].uv});
+    }
+    builder.indices.reserve(indices.size() - meshIndexStart);
+    for (size_t i = meshIndexStart; i < indices.size(); i++) builder.indices.push_back(indices[i] - meshVertexStart);
+    lveMesh->model = std::make_shared<LveModel>(lveDevice, builder, geometryPool);
+
     node->mesh = lveMesh.get();
     meshes.push_back(std::move(lveMesh));
   }
@@ -121,6 +173,7 @@ std::unique_ptr<LveGltfModel::Node> LveGltfModel::loadNode(Node* parent, const t
 }
 
 void LveGltfModel::bind(VkCommandBuffer cmd) {
+  assert(vertexBuffer && "pooled gltf models are drawn through their instantiated entities");
   VkBuffer buffers[] = {vertexBuffer->getBuffer()};
   VkDeviceSize offsets[] = {0};
   vkCmdBindVertexBuffers(cmd, 0, 1, buffers, offsets);
@@ -140,6 +193,24 @@ void LveGltfModel::drawNode(Node* node, VkCommandBuffer cmd, VkPipelineLayout la
   for (const auto& child : node->children) drawNode(child.get(), cmd, layout);
 }
 
+LveEntity LveGltfModel::instantiate(LveScene& scene, LveEntity parent, const MaterialComponent* material) const {
+  LveEntity root = scene.createEntity();
+  scene.setParent(root, parent);
+  for (const auto& node : nodes) instantiateNode(*node, scene, root, material);
+  return root;
+}
+
+void LveGltfModel::instantiateNode(const Node& node, LveScene& scene, LveEntity parent, const MaterialComponent* material) const {
+  LveEntity entity = scene.createEntity(node.name);
+  scene.get<TransformComponent>(entity).setFromMatrix(node.matrix);
+  scene.setParent(entity, parent);
+  if (node.mesh) {
+    scene.add<MeshComponent>(entity, {node.mesh->model});
+    if (material) scene.add<MaterialComponent>(entity, *material);
+  }
+  for (const auto& child : node.children) instantiateNode(*child, scene, entity, material);
+}
+
 std::vector<VkVertexInputBindingDescription> LveGltfModel::Vertex::getBindingDescriptions() {
   std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
   bindingDescriptions[0].binding = 0;
@@ -3,6 +3,8 @@
 #include "core/lve_device.hpp"
 #include "renderer/lve_buffer.hpp"
 #include "renderer/lve_texture.hpp"
+#include "scene/lve_model.hpp"
+#include "scene/lve_scene.hpp"
 
 #include <glm/glm.hpp>
 #include <tinygltf/tiny_gltf.h>
@@ -46,6 +48,8 @@ class LveGltfModel {
 
   struct Mesh {
     std::vector<Primitive> primitives;
+    // every primitive in one scene model, shared by the entities instantiate() creates
+    std::shared_ptr<LveModel> model;
   };
 
   struct Node {
@@ -53,9 +57,11 @@ class LveGltfModel {
     std::vector<std::unique_ptr<Node>> children;
     Mesh* mesh;
     glm::mat4 matrix;
+    std::string name;
   };
 
-  LveGltfModel(LveDevice &device, const std::string &filepath);
+  // the scene models are suballocated from pool when given, and bind() and draw() are then unavailable
+  LveGltfModel(LveDevice &device, const std::string &filepath, LveGeometryPool *pool = nullptr);
   ~LveGltfModel();
 
   LveGltfModel(const LveGltfModel &) = delete;
@@ -64,6 +70,13 @@ class LveGltfModel {
   void bind(VkCommandBuffer commandBuffer);
   void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
 
+  /**
+   * mirrors the node hierarchy into the scene as one entity per node, parented like the nodes and
+   * under parent when given. nodes with a mesh get its model, and a copy of material when given.
+   * returns the entity grouping the gltf scene's root nodes.
+   */
+  LveEntity instantiate(LveScene &scene, LveEntity parent = {}, const MaterialComponent *material = nullptr) const;
+
  private:
   void loadFromFile(const std::string &filepath);
   void loadNodes(tinygltf::Model &input);
@@ -71,8 +84,10 @@ class LveGltfModel {
   
   std::unique_ptr<Node> loadNode(Node* parent, const tinygltf::Node &inputNode, uint32_t nodeIndex, const tinygltf::Model &inputModel);
   void drawNode(Node* node, VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+  void instantiateNode(const Node &node, LveScene &scene, LveEntity parent, const MaterialComponent *material) const;
 
   LveDevice &lveDevice;
+  LveGeometryPool *geometryPool;
 
   std::unique_ptr<LveBuffer> vertexBuffer;
   std::unique_ptr<LveBuffer> indexBuffer;
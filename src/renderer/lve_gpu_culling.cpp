@@ -0,0 +1,491 @@
+#include "renderer/lve_gpu_culling.hpp"
+
+#include "renderer/lve_instance_data.hpp"
+#include "scene/lve_scene.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * gpu culler implementation.
+ * each frame slot owns its buffers, so host writes never race a frame still in flight. a structural
+ * change (meshes added, removed or retextured) regroups the batches and rewrites every slot's records
+ * as it comes around; otherwise only instances whose transform version moved are written.
+ * the visibility bits and the depth pyramid outlive the slots, each cull set is pointed at the current
+ * ones when they are replaced.
+ */
+
+namespace lve {
+
+namespace {
+
+// matches CullRecord in cull.comp (std430)
+struct CullRecord {
+  glm::vec4 center{};
+  glm::vec4 extent{};
+  uint32_t indexCount = 0;
+  uint32_t firstIndex = 0;
+  int32_t vertexOffset = 0;
+  uint32_t batches[LveGpuCuller::VIEW_COUNT] = {};
+  uint32_t padding[2] = {};
+};
+
+static_assert(sizeof(CullRecord) == 64, "cull record must match the std430 shader struct");
+
+struct CullPushConstantData {
+  glm::vec4 planes[6];
+  uint32_t objectCount;
+  uint32_t view;
+  uint32_t occlusion;
+  uint32_t occludedCount;  // index of the occluded counter in the count buffer
+};
+
+// matches ViewBuffer in cull.comp (std430)
+struct CullViews {
+  glm::mat4 occlusionMatrices[LveGpuCuller::VIEW_COUNT];
+  glm::mat4 lightView;
+  glm::vec4 receiverMin;
+  glm::vec4 receiverMax;
+};
+
+// matches the bits in cull.comp
+constexpr uint32_t VISIBLE_LAST_FRAME = 1;
+
+// light view space bounds of the camera frustum, which holds every receiver a visible shadow can fall on
+void frustumBoundsInView(const glm::mat4 &viewProjection, const glm::mat4 &view, glm::vec4 &min, glm::vec4 &max) {
+  const glm::mat4 inverse = glm::inverse(viewProjection);
+  min = glm::vec4{std::numeric_limits<float>::max()};
+  max = glm::vec4{std::numeric_limits<float>::lowest()};
+  for (int i = 0; i < 8; i++) {
+    glm::vec4 corner = inverse * glm::vec4((i & 1) ? 1.f : -1.f, (i & 2) ? 1.f : -1.f, (i & 4) ? 1.f : 0.f, 1.f);
+    corner = view * (corner / corner.w);
+    min = glm::min(min, corner);
+    max = glm::max(max, corner);
+  }
+}
+
+}  // namespace
+
+LveGpuCuller::LveGpuCuller(LveDevice &device, uint32_t framesInFlight) : lveDevice{device}, depthPyramid{device, framesInFlight} {
+  cullSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                      .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .addBinding(7, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .build();
+  // defined like the frame allocator's layout, so the set binds where per instance data is expected
+  instanceSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                          .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                          .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                          .build();
+  descriptorPool = LveDescriptorPool::Builder(lveDevice)
+                       .setMaxSets(2 * framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 7 * framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, framesInFlight)
+                       .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, framesInFlight)
+                       .build();
+  frames.resize(framesInFlight);
+  createPipeline();
+}
+
+LveGpuCuller::~LveGpuCuller() {
+  vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+}
+
+void LveGpuCuller::createPipeline() {
+  VkPushConstantRange range{};
+  range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  range.offset = 0;
+  range.size = sizeof(CullPushConstantData);
+
+  VkDescriptorSetLayout setLayout = cullSetLayout->getDescriptorSetLayout();
+  VkPipelineLayoutCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  info.setLayoutCount = 1;
+  info.pSetLayouts = &setLayout;
+  info.pushConstantRangeCount = 1;
+  info.pPushConstantRanges = &range;
+  if (vkCreatePipelineLayout(lveDevice.device(), &info, nullptr, &pipelineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create cull pipeline layout");
+
+  pipeline = std::make_unique<LveComputePipeline>(lveDevice, "shaders/cull.comp.spv", pipelineLayout);
+}
+
+VkDeviceSize LveGpuCuller::getCommandOffset(View view, uint32_t batch) const noexcept {
+  return static_cast<VkDeviceSize>(batches[view][batch].firstCommand) * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+VkDeviceSize LveGpuCuller::getCountOffset(View view, uint32_t batch) const noexcept {
+  return static_cast<VkDeviceSize>(getBatchBase(view) + batch) * sizeof(uint32_t);
+}
+
+uint32_t LveGpuCuller::getBatchBase(View view) const noexcept {
+  uint32_t base = 0;
+  for (uint32_t previous = 0; previous < view; previous++) base += static_cast<uint32_t>(batches[previous].size());
+  return base;
+}
+
+void LveGpuCuller::setOcclusion(bool enabled) noexcept {
+  // the bits went stale while the late phase was off, everything starts out as visible again
+  if (enabled && !occlusion) {
+    visibilityStale = true;
+    pyramidValid = false;
+  }
+  occlusion = enabled;
+}
+
+void LveGpuCuller::update(const LveScene &scene, int frameIndex, VkExtent2D depthExtent) {
+  currentFrame = frameIndex;
+  auto &frame = frames[frameIndex];
+  frame.retired.clear();
+  readBackStats(frame);
+
+  if (depthPyramid.resize(depthExtent)) {
+    pyramidValid = false;
+    generation++;
+  }
+  if (syncObjects(scene)) {
+    for (auto &slot : frames) slot.recordsStale = true;
+    // ids moved, so the bits no longer belong to the objects they were written for
+    visibilityStale = true;
+  }
+
+  const uint32_t objectCount = getObjectCount();
+  if (!visibility || objectCount > visibilityCapacity) {
+    // frames still in flight may read the old bits, the slot lets go of them once it comes around again
+    if (visibility) frame.retired.push_back(std::move(visibility));
+    visibilityCapacity = std::max({objectCount, 2 * visibilityCapacity, 64u});
+    visibility = std::make_unique<LveBuffer>(
+        lveDevice,
+        sizeof(uint32_t),
+        visibilityCapacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        1,
+        LveMemoryTag::Other);
+    visibilityStale = true;
+    generation++;
+  }
+  reserve(frame);
+  if (frame.writtenGeneration != generation) writeCullSet(frame);
+
+  if (frame.recordsStale) {
+    auto *records = static_cast<CullRecord *>(frame.records->getMappedMemory());
+    for (uint32_t id = 0; id < objectCount; id++) {
+      const auto &box = models[id]->getBoundingBox();
+      CullRecord record{};
+      record.center = glm::vec4((box.min + box.max) * 0.5f, 0.f);
+      record.extent = glm::vec4((box.max - box.min) * 0.5f, 0.f);
+      record.indexCount = models[id]->getIndexCount();
+      record.firstIndex = models[id]->getFirstIndex();
+      record.vertexOffset = models[id]->getVertexOffset();
+      for (uint32_t view = 0; view < VIEW_COUNT; view++) record.batches[view] = objectBatches[view][id];
+      records[id] = record;
+    }
+
+    auto *offsets = static_cast<uint32_t *>(frame.batchOffsets->getMappedMemory());
+    for (uint32_t view = 0; view < VIEW_COUNT; view++) {
+      for (const auto &batch : batches[view]) *offsets++ = batch.firstCommand;
+    }
+    frame.writtenVersions.assign(objectCount, 0);
+    frame.recordsStale = false;
+  }
+
+  const auto &transforms = scene.pool<TransformComponent>();
+  const auto &materials = scene.pool<MaterialComponent>();
+  auto *instances = static_cast<LveInstanceData *>(frame.instances->getMappedMemory());
+  for (uint32_t id = 0; id < objectCount; id++) {
+    // world versions start at 1 once a transform has been updated, so 0 always rewrites
+    const auto &transform = *transforms.find(owners[id]);
+    if (frame.writtenVersions[id] == transform.getWorldVersion() && frame.writtenVersions[id] != 0) continue;
+    const auto *material = materials.find(owners[id]);
+    LveInstanceData instance{};
+    instance.modelMatrix = transform.mat4();
+    instance.normalMatrix = transform.normalMatrix();
+    if (material) instance.uvScale = material->uvScale;
+    instances[id] = instance;
+    frame.writtenVersions[id] = transform.getWorldVersion();
+  }
+}
+
+bool LveGpuCuller::syncObjects(const LveScene &scene) {
+  const auto &meshes = scene.pool<MeshComponent>();
+  const auto &materials = scene.pool<MaterialComponent>();
+  bool changed = false;
+  uint32_t id = 0;
+  for (uint32_t slot = 0; slot < meshes.size(); slot++) {
+    // every loaded mesh is indexed, draws without an index buffer cannot go through the indexed commands
+    LveModel *model = meshes.at(slot).model.get();
+    if (!model || !model->hasIndices()) continue;
+    uint32_t owner = meshes.ownerAt(slot);
+    const auto *material = materials.find(owner);
+    VkDescriptorSet textureSet = material ? material->textureDescriptorSet : VK_NULL_HANDLE;
+
+    if (id == owners.size()) {
+      owners.push_back(owner);
+      models.push_back(model);
+      textures.push_back(textureSet);
+      changed = true;
+    } else if (owners[id] != owner || models[id] != model || textures[id] != textureSet) {
+      owners[id] = owner;
+      models[id] = model;
+      textures[id] = textureSet;
+      changed = true;
+    }
+    id++;
+  }
+  if (id != owners.size()) {
+    owners.resize(id);
+    models.resize(id);
+    textures.resize(id);
+    changed = true;
+  }
+
+  if (changed) rebuildBatches();
+  return changed;
+}
+
+void LveGpuCuller::rebuildBatches() {
+  const uint32_t objectCount = getObjectCount();
+  // the camera views need the textures to match as well, the depth only shadow pass only the buffers
+  std::map<std::pair<uint64_t, VkDescriptorSet>, uint32_t> batchIds[VIEW_COUNT];
+  for (uint32_t view = 0; view < VIEW_COUNT; view++) {
+    batches[view].clear();
+    objectBatches[view].resize(objectCount);
+    for (uint32_t id = 0; id < objectCount; id++) {
+      VkDescriptorSet textureSet = view != SHADOW ? textures[id] : VK_NULL_HANDLE;
+      auto [it, inserted] = batchIds[view].try_emplace({models[id]->getBindingId(), textureSet}, static_cast<uint32_t>(batches[view].size()));
+      if (inserted) batches[view].push_back({models[id], textureSet, 0, 0});
+      batches[view][it->second].maxDraws++;
+      objectBatches[view][id] = it->second;
+    }
+  }
+
+  // commands and counts follow the view order; record batch ids index the shared offset and count arrays
+  uint32_t firstCommand = 0;
+  for (uint32_t view = 0; view < VIEW_COUNT; view++) {
+    for (auto &batch : batches[view]) {
+      batch.firstCommand = firstCommand;
+      firstCommand += batch.maxDraws;
+    }
+    const uint32_t base = getBatchBase(static_cast<View>(view));
+    for (auto &batch : objectBatches[view]) batch += base;
+  }
+}
+
+void LveGpuCuller::reserve(FrameResources &frame) {
+  const uint32_t objectCount = getObjectCount();
+  const uint32_t batchCount = getBatchBase(VIEW_COUNT);
+  if (frame.records && objectCount <= frame.objectCapacity && batchCount <= frame.batchCapacity) return;
+
+  // grow geometrically so a scene filling up over several frames does not reallocate every time
+  frame.objectCapacity = std::max({objectCount, 2 * frame.objectCapacity, 64u});
+  frame.batchCapacity = std::max({batchCount, 2 * frame.batchCapacity, 16u});
+  const auto memoryProperties = lveDevice.dynamicMemoryProperties();
+  frame.records = std::make_unique<LveBuffer>(
+      lveDevice, sizeof(CullRecord), frame.objectCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, memoryProperties, 1, LveMemoryTag::Uniform);
+  frame.instances = std::make_unique<LveBuffer>(
+      lveDevice,
+      sizeof(LveInstanceData),
+      frame.objectCapacity,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      memoryProperties,
+      1,
+      LveMemoryTag::Uniform);
+  frame.batchOffsets = std::make_unique<LveBuffer>(
+      lveDevice, sizeof(uint32_t), frame.batchCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, memoryProperties, 1, LveMemoryTag::Uniform);
+  frame.commands = std::make_unique<LveBuffer>(
+      lveDevice,
+      sizeof(VkDrawIndexedIndirectCommand),
+      VIEW_COUNT * frame.objectCapacity,
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      1,
+      LveMemoryTag::Other);
+  // host visible so the draw counts can be read back for stats
+  frame.counts = std::make_unique<LveBuffer>(
+      lveDevice,
+      sizeof(uint32_t),
+      frame.batchCapacity + 1,
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      memoryProperties,
+      1,
+      LveMemoryTag::Other);
+  if (!frame.views) {
+    frame.views = std::make_unique<LveBuffer>(
+        lveDevice, sizeof(CullViews), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, memoryProperties, 1, LveMemoryTag::Uniform);
+    frame.views->map();
+  }
+  for (auto *buffer : {frame.records.get(), frame.instances.get(), frame.batchOffsets.get(), frame.counts.get()}) buffer->map();
+
+  // binding 0 is never read, but a uniform range may not exceed the device limit
+  auto uniformInfo = frame.instances->descriptorInfo(std::min<VkDeviceSize>(frame.instances->getBufferSize(), lveDevice.properties.limits.maxUniformBufferRange), 0);
+  auto storageInfo = frame.instances->descriptorInfo(frame.instances->getBufferSize(), 0);
+  LveDescriptorWriter instanceWriter{*instanceSetLayout, *descriptorPool};
+  instanceWriter.writeBuffer(0, &uniformInfo).writeBuffer(1, &storageInfo);
+  if (frame.instanceSet == VK_NULL_HANDLE) {
+    if (!instanceWriter.build(frame.instanceSet)) throw std::runtime_error("failed to allocate gpu culling descriptor sets");
+  } else {
+    instanceWriter.overwrite(frame.instanceSet);
+  }
+
+  frame.recordsStale = true;
+  frame.writtenGeneration = 0;
+  frame.culledObjects = 0;
+}
+
+void LveGpuCuller::writeCullSet(FrameResources &frame) {
+  auto recordInfo = frame.records->descriptorInfo();
+  auto instanceInfo = frame.instances->descriptorInfo();
+  auto offsetInfo = frame.batchOffsets->descriptorInfo();
+  auto commandInfo = frame.commands->descriptorInfo();
+  auto countInfo = frame.counts->descriptorInfo();
+  auto viewInfo = frame.views->descriptorInfo();
+  auto visibilityInfo = visibility->descriptorInfo();
+  auto pyramidInfo = depthPyramid.descriptorInfo();
+  LveDescriptorWriter cullWriter{*cullSetLayout, *descriptorPool};
+  cullWriter.writeBuffer(0, &recordInfo)
+      .writeBuffer(1, &instanceInfo)
+      .writeBuffer(2, &offsetInfo)
+      .writeBuffer(3, &commandInfo)
+      .writeBuffer(4, &countInfo)
+      .writeBuffer(5, &viewInfo)
+      .writeBuffer(6, &visibilityInfo)
+      .writeImage(7, &pyramidInfo);
+
+  if (frame.cullSet == VK_NULL_HANDLE) {
+    if (!cullWriter.build(frame.cullSet)) throw std::runtime_error("failed to allocate gpu culling descriptor sets");
+  } else {
+    cullWriter.overwrite(frame.cullSet);
+  }
+  frame.writtenGeneration = generation;
+}
+
+void LveGpuCuller::readBackStats(FrameResources &frame) {
+  if (!frame.counts || frame.culledObjects == 0) return;
+  frame.counts->invalidate();
+  const auto *counts = static_cast<const uint32_t *>(frame.counts->getMappedMemory());
+  uint32_t visible[VIEW_COUNT] = {};
+  for (uint32_t view = 0; view < VIEW_COUNT; view++) {
+    for (uint32_t batch = 0; batch < frame.culledBatches[view]; batch++) visible[view] += *counts++;
+  }
+  // the occluded counter sits right after the last batch
+  const uint32_t occluded = frame.culledLate ? *counts : 0;
+  const uint32_t cameraVisible = visible[CAMERA] + visible[CAMERA_LATE];
+  stats[CAMERA] = {cameraVisible, frame.culledObjects - cameraVisible - occluded, occluded};
+  stats[CAMERA_LATE] = {visible[CAMERA_LATE], 0, 0};
+  stats[SHADOW] = {visible[SHADOW], frame.culledObjects - visible[SHADOW], 0};
+}
+
+void LveGpuCuller::cull(
+    VkCommandBuffer commandBuffer,
+    const LveFrustum &cameraFrustum,
+    const LveFrustum &lightFrustum,
+    const glm::mat4 &cameraViewProjection,
+    const glm::mat4 &lightView) {
+  auto &frame = frames[currentFrame];
+  const uint32_t objectCount = getObjectCount();
+  frame.culledObjects = objectCount;
+  for (uint32_t view = 0; view < VIEW_COUNT; view++) frame.culledBatches[view] = static_cast<uint32_t>(batches[view].size());
+  frame.culledLate = false;
+  lateFrustum = cameraFrustum;
+  lateViewProjection = cameraViewProjection;
+  if (objectCount == 0) return;
+
+  // the early phase tests against the pyramid with the matrix it was built with, the late one with this frame's
+  auto *views = static_cast<CullViews *>(frame.views->getMappedMemory());
+  views->occlusionMatrices[CAMERA] = pyramidViewProjection;
+  views->occlusionMatrices[CAMERA_LATE] = cameraViewProjection;
+  views->lightView = lightView;
+  frustumBoundsInView(cameraViewProjection, lightView, views->receiverMin, views->receiverMax);
+  frame.views->flush();
+
+  const VkDeviceSize countBytes = (getBatchBase(VIEW_COUNT) + 1) * sizeof(uint32_t);
+  vkCmdFillBuffer(commandBuffer, frame.counts->getBuffer(), 0, countBytes, 0);
+  if (visibilityStale) {
+    vkCmdFillBuffer(commandBuffer, visibility->getBuffer(), 0, VK_WHOLE_SIZE, VISIBLE_LAST_FRAME);
+    visibilityStale = false;
+  }
+  // also orders the previous frame's late phase and pyramid writes before this frame reads them
+  VkMemoryBarrier clearBarrier{};
+  clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &clearBarrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+  pipeline->bind(commandBuffer);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.cullSet, 0, nullptr);
+  // without a pyramid to test against the early phase draws everything in the frustum
+  dispatch(commandBuffer, CAMERA, cameraFrustum, occlusion && pyramidValid);
+  dispatch(commandBuffer, SHADOW, lightFrustum, false);
+
+  // the host reads the counts back once the slot's fence has signalled
+  drawBarrier(commandBuffer);
+}
+
+void LveGpuCuller::cullLate(VkCommandBuffer commandBuffer, VkImageView depthView) {
+  auto &frame = frames[currentFrame];
+  if (!occlusion || getObjectCount() == 0) return;
+
+  depthPyramid.build(commandBuffer, currentFrame, depthView);
+  pyramidViewProjection = lateViewProjection;
+  pyramidValid = true;
+
+  // the pyramid's barriers also order the early phase's visibility writes before these reads
+  pipeline->bind(commandBuffer);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.cullSet, 0, nullptr);
+  dispatch(commandBuffer, CAMERA_LATE, lateFrustum, true);
+  frame.culledLate = true;
+
+  drawBarrier(commandBuffer);
+}
+
+void LveGpuCuller::dispatch(VkCommandBuffer commandBuffer, View view, const LveFrustum &frustum, bool testOcclusion) {
+  const uint32_t objectCount = getObjectCount();
+  CullPushConstantData push{};
+  std::copy(std::begin(frustum.planes), std::end(frustum.planes), push.planes);
+  push.objectCount = objectCount;
+  push.view = view;
+  push.occlusion = testOcclusion ? 1 : 0;
+  push.occludedCount = getBatchBase(VIEW_COUNT);
+  vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstantData), &push);
+  vkCmdDispatch(commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+}
+
+void LveGpuCuller::drawBarrier(VkCommandBuffer commandBuffer) {
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+      0,
+      1,
+      &barrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+}
+
+}  // namespace lve
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "core/lve_device.hpp"
+#include "renderer/lve_buffer.hpp"
+#include "renderer/lve_depth_pyramid.hpp"
+#include "renderer/lve_descriptors.hpp"
+#include "renderer/lve_pipeline.hpp"
+#include "scene/lve_culling.hpp"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * gpu driven culling and indirect submission.
+ * every mesh keeps a persistent record (model space bounds, index range, batch) and instance data
+ * (matrices, uv scale) in per frame slot buffers, rewritten only for objects that changed since the
+ * slot was last used. a compute pass tests the records against the camera and light frusta and
+ * appends one VkDrawIndexedIndirectCommand per survivor to its batch, so the passes submit one
+ * vkCmdDrawIndexedIndirectCount per batch however many objects the scene holds.
+ *
+ * with occlusion on, the camera draws in two phases. the early phase draws what was visible last frame
+ * and is not hidden behind last frame's depth pyramid; the pyramid is then rebuilt from that depth and
+ * the late phase draws whatever became visible, so the image never misses an object and only the
+ * objects that just came into view are drawn with a frame of delay in their occluders.
+ */
+
+namespace lve {
+
+class LveModel;
+class LveScene;
+
+class LveGpuCuller {
+ public:
+  // CAMERA_LATE holds the late phase's draws, its batches mirror the camera's
+  enum View : uint32_t { CAMERA = 0, CAMERA_LATE = 1, SHADOW = 2, VIEW_COUNT = 3 };
+
+  /**
+   * draws that can share one indirect call: the same bound buffers, and for the camera views the same
+   * texture set. commands for the batch live at [firstCommand, firstCommand + maxDraws).
+   */
+  struct Batch {
+    LveModel *model = nullptr;  // any model of the batch, bind() binds the buffers they all share
+    VkDescriptorSet textures = VK_NULL_HANDLE;
+    uint32_t firstCommand = 0;
+    uint32_t maxDraws = 0;
+  };
+
+  LveGpuCuller(LveDevice &device, uint32_t framesInFlight);
+  ~LveGpuCuller();
+
+  LveGpuCuller(const LveGpuCuller &) = delete;
+  LveGpuCuller &operator=(const LveGpuCuller &) = delete;
+
+  /**
+   * syncs frameIndex's buffers with the scene after updateTransforms(). only call once the renderer
+   * has handed out that frame context again; the draw counts it last produced are read back here.
+   * depthExtent is the swap chain's, the depth pyramid follows it.
+   */
+  void update(const LveScene &scene, int frameIndex, VkExtent2D depthExtent);
+
+  /**
+   * records the count reset and the early camera and shadow dispatches, outside of any render pass and
+   * before the passes draw. cameraViewProjection is the matrix the late phase tests against. casters
+   * are kept like LveFrustumCuller::cullShadowCasters keeps them, with the camera frustum in the light's
+   * view space, lightView, standing in for the visible receivers.
+   */
+  void cull(
+      VkCommandBuffer commandBuffer,
+      const LveFrustum &cameraFrustum,
+      const LveFrustum &lightFrustum,
+      const glm::mat4 &cameraViewProjection,
+      const glm::mat4 &lightView);
+
+  /**
+   * after the early camera draws: rebuilds the depth pyramid from depthView, which the early pass left
+   * in shader read only layout, then culls everything the early phase skipped against it. with
+   * occlusion off the main pass is not split and this records nothing.
+   */
+  void cullLate(VkCommandBuffer commandBuffer, VkImageView depthView);
+
+  void setOcclusion(bool enabled) noexcept;
+  bool getOcclusion() const noexcept { return occlusion; }
+
+  const std::vector<Batch> &getBatches(View view) const noexcept { return batches[view]; }
+  VkBuffer getCommandBuffer() const noexcept { return frames[currentFrame].commands->getBuffer(); }
+  VkBuffer getCountBuffer() const noexcept { return frames[currentFrame].counts->getBuffer(); }
+  // byte offsets of a batch's first command and of its draw count
+  VkDeviceSize getCommandOffset(View view, uint32_t batch) const noexcept;
+  VkDeviceSize getCountOffset(View view, uint32_t batch) const noexcept;
+
+  /** layout compatible with the frame allocator's set, with the instance data at binding 1 and no offset. */
+  VkDescriptorSet getInstanceSet() const noexcept { return frames[currentFrame].instanceSet; }
+
+  // what the culling produced the last time the current slot was used, so a few frames old. the camera's
+  // visible count covers both phases, CAMERA_LATE's only what the late phase added
+  const LveCullStats &getStats(View view) const noexcept { return stats[view]; }
+  uint32_t getObjectCount() const noexcept { return static_cast<uint32_t>(owners.size()); }
+
+ private:
+  static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+  struct FrameResources {
+    std::unique_ptr<LveBuffer> records;
+    std::unique_ptr<LveBuffer> instances;
+    std::unique_ptr<LveBuffer> batchOffsets;
+    std::unique_ptr<LveBuffer> commands;
+    // every batch's draw count, then the late phase's occluded count
+    std::unique_ptr<LveBuffer> counts;
+    // the matrix each view's occlusion test projects with, and the shadow view's receiver bounds
+    std::unique_ptr<LveBuffer> views;
+    VkDescriptorSet cullSet = VK_NULL_HANDLE;
+    VkDescriptorSet instanceSet = VK_NULL_HANDLE;
+    uint32_t objectCapacity = 0;
+    uint32_t batchCapacity = 0;
+    // world version each object's instance data was written with, 0 when never
+    std::vector<uint32_t> writtenVersions;
+    bool recordsStale = true;
+    // the visibility buffer and pyramid the cull set was written with
+    uint32_t writtenGeneration = 0;
+    // buffers replaced while the slot's last frame could still read them
+    std::vector<std::unique_ptr<LveBuffer>> retired;
+    // layout of the counts the slot's last cull wrote
+    uint32_t culledObjects = 0;
+    uint32_t culledBatches[VIEW_COUNT] = {};
+    bool culledLate = false;
+  };
+
+  void createPipeline();
+  bool syncObjects(const LveScene &scene);
+  void rebuildBatches();
+  void reserve(FrameResources &frame);
+  void writeCullSet(FrameResources &frame);
+  void dispatch(VkCommandBuffer commandBuffer, View view, const LveFrustum &frustum, bool testOcclusion);
+  void drawBarrier(VkCommandBuffer commandBuffer);
+  uint32_t getBatchBase(View view) const noexcept;
+  void readBackStats(FrameResources &frame);
+
+  LveDevice &lveDevice;
+  std::unique_ptr<LveDescriptorSetLayout> cullSetLayout;
+  std::unique_ptr<LveDescriptorSetLayout> instanceSetLayout;
+  std::unique_ptr<LveDescriptorPool> descriptorPool;
+  VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+  std::unique_ptr<LveComputePipeline> pipeline;
+
+  std::vector<FrameResources> frames;
+  int currentFrame = 0;
+
+  // per object bits carried from one frame's culling to the next, shared by all slots since every frame
+  // reads what the one before it wrote; queue order keeps the frames from overlapping on it
+  std::unique_ptr<LveBuffer> visibility;
+  uint32_t visibilityCapacity = 0;
+  bool visibilityStale = true;
+  LveDepthPyramid depthPyramid;
+  // the camera matrix the pyramid was last built with, which the next early phase projects with
+  glm::mat4 pyramidViewProjection{1.f};
+  // the camera's frustum and matrix this frame, kept for the late phase
+  LveFrustum lateFrustum{};
+  glm::mat4 lateViewProjection{1.f};
+  bool pyramidValid = false;
+  bool occlusion = true;
+  // bumped whenever the visibility buffer or pyramid image is replaced
+  uint32_t generation = 1;
+
+  // one entry per indexed mesh, by object id (which is also its firstInstance)
+  std::vector<uint32_t> owners;
+  std::vector<LveModel *> models;
+  std::vector<VkDescriptorSet> textures;
+  std::vector<uint32_t> objectBatches[VIEW_COUNT];
+
+  std::vector<Batch> batches[VIEW_COUNT];
+  LveCullStats stats[VIEW_COUNT]{};
+};
+
+}  // namespace lve
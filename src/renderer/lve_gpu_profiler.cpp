@@ -0,0 +1,110 @@
+#include "renderer/lve_gpu_profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * gpu profiler implementation.
+ * results are queried with availability, so a scope whose end was never recorded is skipped
+ * instead of failing the readback of the whole frame.
+ */
+
+namespace lve {
+
+LveGpuProfiler::LveGpuProfiler(LveDevice &device, uint32_t framesInFlight) : lveDevice{device} {
+  frameScopes.resize(framesInFlight);
+  // without this limit only some queues could write timestamps, leave profiling off in that case
+  if (!lveDevice.properties.limits.timestampComputeAndGraphics) return;
+
+  timestampPeriod = lveDevice.properties.limits.timestampPeriod;
+  uint32_t validBits = lveDevice.timestampValidBits();
+  if (validBits == 0) return;
+  timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+  VkQueryPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  poolInfo.queryCount = framesInFlight * MAX_SCOPES * 2;
+  if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) throw std::runtime_error("failed to create timestamp query pool");
+}
+
+LveGpuProfiler::~LveGpuProfiler() {
+  if (queryPool) vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+}
+
+void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+  currentFrame = frameIndex;
+  if (!queryPool) return;
+  collect(frameIndex);
+  frameScopes[frameIndex].clear();
+  vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * MAX_SCOPES * 2, MAX_SCOPES * 2);
+}
+
+uint32_t LveGpuProfiler::createScope(const char *name) {
+  auto &scopes = frameScopes[currentFrame];
+  if (!queryPool || scopes.size() == MAX_SCOPES) return NO_SCOPE;
+  scopes.push_back(name);
+  return static_cast<uint32_t>(scopes.size() - 1);
+}
+
+void LveGpuProfiler::writeBegin(VkCommandBuffer commandBuffer, uint32_t scope) {
+  if (scope == NO_SCOPE) return;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, (currentFrame * MAX_SCOPES + scope) * 2);
+}
+
+void LveGpuProfiler::writeEnd(VkCommandBuffer commandBuffer, uint32_t scope) {
+  if (scope == NO_SCOPE) return;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, (currentFrame * MAX_SCOPES + scope) * 2 + 1);
+}
+
+void LveGpuProfiler::collect(int frameIndex) {
+  const auto &scopes = frameScopes[frameIndex];
+  if (scopes.empty()) return;
+
+  // value and availability per query
+  std::vector<uint64_t> data(scopes.size() * 2 * 2);
+  vkGetQueryPoolResults(
+      lveDevice.device(),
+      queryPool,
+      frameIndex * MAX_SCOPES * 2,
+      static_cast<uint32_t>(scopes.size() * 2),
+      data.size() * sizeof(uint64_t),
+      data.data(),
+      2 * sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+  for (size_t i = 0; i < scopes.size(); i++) {
+    const uint64_t *begin = &data[i * 4];
+    const uint64_t *end = &data[i * 4 + 2];
+    if (!begin[1] || !end[1]) continue;
+
+    uint64_t ticks = ((end[0] & timestampMask) - (begin[0] & timestampMask)) & timestampMask;
+    float ms = static_cast<float>(static_cast<double>(ticks) * timestampPeriod / 1e6);
+
+    auto &stats = statsFor(scopes[i]);
+    stats.lastMs = ms;
+    stats.history[stats.sampleCount % HISTORY] = ms;
+    stats.sampleCount++;
+    uint32_t window = std::min(stats.sampleCount, HISTORY);
+    float sum = 0.f;
+    for (uint32_t s = 0; s < window; s++) sum += stats.history[s];
+    stats.averageMs = sum / static_cast<float>(window);
+  }
+}
+
+LveGpuProfiler::ScopeStats &LveGpuProfiler::statsFor(const std::string &name) {
+  auto it = std::find_if(results.begin(), results.end(), [&](const auto &s) { return s.name == name; });
+  if (it != results.end()) return *it;
+  results.push_back(ScopeStats{});
+  results.back().name = name;
+  return results.back();
+}
+
+float LveGpuProfiler::getAverageMs(const std::string &name) const noexcept {
+  for (const auto &stats : results) {
+    if (stats.name == name) return stats.averageMs;
+  }
+  return 0.f;
+}
+
+}  // namespace lve
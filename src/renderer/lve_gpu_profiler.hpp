@@ -0,0 +1,94 @@
+#pragma once
+
+#include "core/lve_device.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * timestamp query based gpu profiler.
+ * each frame in flight owns a slice of one query pool; a frame's timestamps are read back when
+ * its slot comes around again, after the renderer already waited for it on the frame timeline, so reading never stalls.
+ */
+
+namespace lve {
+
+class LveGpuProfiler {
+ public:
+  static constexpr uint32_t MAX_SCOPES = 32;
+  static constexpr uint32_t HISTORY = 60;
+  static constexpr uint32_t NO_SCOPE = ~0u;
+
+  /** rolling timings of all scopes recorded under one name. */
+  struct ScopeStats {
+    std::string name;
+    float lastMs = 0.f;
+    float averageMs = 0.f;
+    std::array<float, HISTORY> history{};
+    uint32_t sampleCount = 0;
+  };
+
+  /** writes a scope's begin timestamp on construction and its end on destruction. */
+  class Scope {
+   public:
+    Scope(LveGpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name)
+        : profiler{profiler}, commandBuffer{commandBuffer}, scope{profiler.beginScope(commandBuffer, name)} {}
+    ~Scope() { profiler.writeEnd(commandBuffer, scope); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    LveGpuProfiler &profiler;
+    VkCommandBuffer commandBuffer;
+    uint32_t scope;
+  };
+
+  LveGpuProfiler(LveDevice &device, uint32_t framesInFlight);
+  ~LveGpuProfiler();
+
+  LveGpuProfiler(const LveGpuProfiler &) = delete;
+  LveGpuProfiler &operator=(const LveGpuProfiler &) = delete;
+
+  /**
+   * collects the results frameIndex recorded last time and resets its queries. must be recorded
+   * into the frame's primary buffer outside of any render pass, once the gpu finished the slot's previous frame.
+   */
+  void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+  /**
+   * reserves a scope for this frame. begin and end may be written into different command buffers
+   * (the first and last secondary of a split pass) as long as they execute in that order.
+   * main thread only; returns NO_SCOPE when profiling is unsupported or the frame is full.
+   */
+  uint32_t createScope(const char *name);
+  void writeBegin(VkCommandBuffer commandBuffer, uint32_t scope);
+  void writeEnd(VkCommandBuffer commandBuffer, uint32_t scope);
+  uint32_t beginScope(VkCommandBuffer commandBuffer, const char *name) {
+    uint32_t scope = createScope(name);
+    writeBegin(commandBuffer, scope);
+    return scope;
+  }
+
+  bool isSupported() const noexcept { return queryPool != VK_NULL_HANDLE; }
+  const std::vector<ScopeStats> &getResults() const noexcept { return results; }
+  // rolling average in milliseconds, 0 when the scope has not been seen yet
+  float getAverageMs(const std::string &name) const noexcept;
+
+ private:
+  void collect(int frameIndex);
+  ScopeStats &statsFor(const std::string &name);
+
+  LveDevice &lveDevice;
+  VkQueryPool queryPool = VK_NULL_HANDLE;
+  float timestampPeriod = 1.f;
+  uint64_t timestampMask = ~0ull;
+
+  // per frame in flight: names of the scopes recorded into it, index i uses queries 2i and 2i + 1
+  std::vector<std::vector<const char *>> frameScopes;
+  int currentFrame = 0;
+  std::vector<ScopeStats> results;
+};
+
+}  // namespace lve
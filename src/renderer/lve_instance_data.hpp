@@ -0,0 +1,24 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+/**
+ * per-instance shader data.
+ * matches InstanceData in simple_shader.vert and shadow.vert (std430), read by gl_InstanceIndex
+ * from the storage binding of the frame allocator's set layout.
+ */
+
+namespace lve {
+
+struct LveInstanceData {
+  glm::mat4 modelMatrix{1.f};
+  glm::mat4 normalMatrix{1.f};
+  glm::vec2 uvScale{1.f, 1.f};
+  glm::vec2 padding{};
+};
+
+static_assert(sizeof(LveInstanceData) == 144, "instance data must match the std430 shader struct");
+
+}  // namespace lve
@@ -19,7 +19,7 @@
 namespace lve {
 
 LvePipeline::LvePipeline(LveDevice& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
-    : lveDevice{device} {
+    : lveDevice{device}, topology{configInfo.inputAssemblyInfo.topology} {
   createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
 }
 
@@ -200,4 +200,37 @@ void LvePipeline::enableAlphaBlending(PipelineConfigInfo& configInfo) {
   configInfo.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 }
 
+LveComputePipeline::LveComputePipeline(LveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout) : lveDevice{device} {
+  assert(pipelineLayout != VK_NULL_HANDLE && "pipeline layout missing");
+  auto code = LvePipeline::readFile(compFilepath);
+
+  VkShaderModuleCreateInfo moduleInfo{};
+  moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleInfo.codeSize = code.size();
+  moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+  if (vkCreateShaderModule(lveDevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create shader module");
+  }
+
+  VkComputePipelineCreateInfo pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipelineInfo.stage.module = compShaderModule;
+  pipelineInfo.stage.pName = "main";
+  pipelineInfo.layout = pipelineLayout;
+  if (vkCreateComputePipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create compute pipeline");
+  }
+}
+
+LveComputePipeline::~LveComputePipeline() {
+  vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+  vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+}
+
+void LveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+}
+
 }  // namespace lve
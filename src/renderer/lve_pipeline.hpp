@@ -46,13 +46,15 @@ class LvePipeline {
   LvePipeline& operator=(const LvePipeline&) = delete;
 
   void bind(VkCommandBuffer commandBuffer);
+  VkPrimitiveTopology getTopology() const noexcept { return topology; }
 
   static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
   static void enableAlphaBlending(PipelineConfigInfo& configInfo);
 
- private:
+  // loads spir-v relative to the engine directory
   static std::vector<char> readFile(const std::string& filepath);
 
+ private:
   void createGraphicsPipeline(
       const std::string& vertFilepath,
       const std::string& fragFilepath,
@@ -64,5 +66,25 @@ class LvePipeline {
   VkPipeline graphicsPipeline;
   VkShaderModule vertShaderModule;
   VkShaderModule fragShaderModule;
+  VkPrimitiveTopology topology;
+};
+
+/**
+ * single stage compute pipeline.
+ */
+class LveComputePipeline {
+ public:
+  LveComputePipeline(LveDevice& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+  ~LveComputePipeline();
+
+  LveComputePipeline(const LveComputePipeline&) = delete;
+  LveComputePipeline& operator=(const LveComputePipeline&) = delete;
+
+  void bind(VkCommandBuffer commandBuffer);
+
+ private:
+  LveDevice& lveDevice;
+  VkPipeline computePipeline;
+  VkShaderModule compShaderModule;
 };
 }  // namespace lve
@@ -0,0 +1,98 @@
+#include "renderer/lve_render_stats.hpp"
+
+#include <stdexcept>
+
+/**
+ * render stats implementation.
+ * pass queries are read with availability, so a pass that was begun but never ended (a frame
+ * dropped for a swap chain rebuild) is skipped instead of failing the whole readback.
+ */
+
+namespace lve {
+
+LveRenderStats::LveRenderStats(LveDevice &device, uint32_t framesInFlight) : lveDevice{device} {
+  framePasses.resize(framesInFlight);
+  if (!lveDevice.hasPipelineStatistics()) return;
+
+  VkQueryPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+  poolInfo.queryCount = framesInFlight * MAX_PASSES;
+  poolInfo.pipelineStatistics = STATISTICS;
+  if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline statistics query pool");
+}
+
+LveRenderStats::~LveRenderStats() {
+  if (queryPool) vkDestroyQueryPool(lveDevice.device(), queryPool, nullptr);
+}
+
+void LveRenderStats::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    lastFrame = current;
+    current = LveDrawCounters{};
+  }
+
+  currentFrame = frameIndex;
+  if (!queryPool) return;
+  collect(frameIndex);
+  framePasses[frameIndex].clear();
+  vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * MAX_PASSES, MAX_PASSES);
+}
+
+uint32_t LveRenderStats::beginPass(VkCommandBuffer commandBuffer, const char *name) {
+  auto &passes = framePasses[currentFrame];
+  if (!queryPool || passes.size() == MAX_PASSES) return NO_PASS;
+  passes.push_back(name);
+  uint32_t pass = static_cast<uint32_t>(passes.size() - 1);
+  vkCmdBeginQuery(commandBuffer, queryPool, currentFrame * MAX_PASSES + pass, 0);
+  return pass;
+}
+
+void LveRenderStats::endPass(VkCommandBuffer commandBuffer, uint32_t pass) {
+  if (pass == NO_PASS) return;
+  vkCmdEndQuery(commandBuffer, queryPool, currentFrame * MAX_PASSES + pass);
+}
+
+void LveRenderStats::merge(const LveDrawCounters &counters) {
+  std::lock_guard<std::mutex> lock{mutex};
+  current += counters;
+}
+
+void LveRenderStats::collect(int frameIndex) {
+  const auto &passes = framePasses[frameIndex];
+  if (passes.empty()) return;
+
+  // three statistics and availability per query
+  constexpr size_t stride = 4;
+  std::vector<uint64_t> data(passes.size() * stride);
+  vkGetQueryPoolResults(
+      lveDevice.device(),
+      queryPool,
+      frameIndex * MAX_PASSES,
+      static_cast<uint32_t>(passes.size()),
+      data.size() * sizeof(uint64_t),
+      data.data(),
+      stride * sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+  for (size_t i = 0; i < passes.size(); i++) {
+    const uint64_t *result = &data[i * stride];
+    if (!result[3]) continue;
+
+    PassStatistics *stats = nullptr;
+    for (auto &existing : passResults) {
+      if (existing.name == passes[i]) stats = &existing;
+    }
+    if (!stats) {
+      passResults.push_back(PassStatistics{});
+      stats = &passResults.back();
+      stats->name = passes[i];
+    }
+    stats->vertexInvocations = result[0];
+    stats->clippingPrimitives = result[1];
+    stats->fragmentInvocations = result[2];
+  }
+}
+
+}  // namespace lve
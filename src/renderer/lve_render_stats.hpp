@@ -0,0 +1,176 @@
+#pragma once
+
+#include "core/lve_device.hpp"
+#include "renderer/lve_pipeline.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * per-frame draw counters and per-pass pipeline statistics.
+ * counters are gathered by LveCommandRecorder, a thin wrapper over the vkCmd* calls the render
+ * systems make, and merged once per command buffer. pass statistics come from pipeline
+ * statistics queries read back when the frame's slot comes around again, like the gpu profiler.
+ */
+
+namespace lve {
+
+struct LveDrawCounters {
+  uint32_t drawCalls = 0;
+  uint64_t triangles = 0;
+  uint32_t pipelineBinds = 0;
+  uint32_t descriptorSetBinds = 0;
+  uint64_t pushConstantBytes = 0;
+  uint32_t bufferBinds = 0;
+
+  LveDrawCounters &operator+=(const LveDrawCounters &other) noexcept {
+    drawCalls += other.drawCalls;
+    triangles += other.triangles;
+    pipelineBinds += other.pipelineBinds;
+    descriptorSetBinds += other.descriptorSetBinds;
+    pushConstantBytes += other.pushConstantBytes;
+    bufferBinds += other.bufferBinds;
+    return *this;
+  }
+};
+
+class LveRenderStats {
+ public:
+  static constexpr uint32_t MAX_PASSES = 4;
+  static constexpr uint32_t NO_PASS = ~0u;
+  // result order follows the bit order of the flags
+  static constexpr VkQueryPipelineStatisticFlags STATISTICS = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                                                              VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                                                              VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+  struct PassStatistics {
+    std::string name;
+    uint64_t vertexInvocations = 0;
+    uint64_t clippingPrimitives = 0;
+    uint64_t fragmentInvocations = 0;
+  };
+
+  LveRenderStats(LveDevice &device, uint32_t framesInFlight);
+  ~LveRenderStats();
+
+  LveRenderStats(const LveRenderStats &) = delete;
+  LveRenderStats &operator=(const LveRenderStats &) = delete;
+
+  /**
+   * publishes the counters of the previous frame, reads back the pass statistics frameIndex
+   * recorded last time and resets its queries. recorded outside of any render pass.
+   */
+  void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+  /** brackets a render pass on the primary buffer, outside vkCmdBeginRenderPass/vkCmdEndRenderPass. */
+  uint32_t beginPass(VkCommandBuffer commandBuffer, const char *name);
+  void endPass(VkCommandBuffer commandBuffer, uint32_t pass);
+
+  // thread safe, called once per recorded command buffer
+  void merge(const LveDrawCounters &counters);
+
+  // what secondaries must declare in their inheritance info while a pass query is active
+  VkQueryPipelineStatisticFlags inheritedStatistics() const noexcept { return queryPool ? STATISTICS : 0; }
+
+  bool hasPipelineStatistics() const noexcept { return queryPool != VK_NULL_HANDLE; }
+  const LveDrawCounters &getLastFrame() const noexcept { return lastFrame; }
+  const std::vector<PassStatistics> &getPassResults() const noexcept { return passResults; }
+
+ private:
+  void collect(int frameIndex);
+
+  LveDevice &lveDevice;
+  VkQueryPool queryPool = VK_NULL_HANDLE;
+
+  std::mutex mutex;
+  LveDrawCounters current{};
+  LveDrawCounters lastFrame{};
+
+  std::vector<std::vector<const char *>> framePasses;
+  int currentFrame = 0;
+  std::vector<PassStatistics> passResults;
+};
+
+/**
+ * records into a command buffer and counts what it records. one recorder per command buffer
+ * and thread; its counters are merged into the frame's stats when it goes out of scope.
+ */
+class LveCommandRecorder {
+ public:
+  LveCommandRecorder(VkCommandBuffer commandBuffer, LveRenderStats &stats) noexcept : commandBuffer{commandBuffer}, stats{stats} {}
+  ~LveCommandRecorder() { stats.merge(counters); }
+
+  LveCommandRecorder(const LveCommandRecorder &) = delete;
+  LveCommandRecorder &operator=(const LveCommandRecorder &) = delete;
+
+  VkCommandBuffer getCommandBuffer() const noexcept { return commandBuffer; }
+  const LveDrawCounters &getCounters() const noexcept { return counters; }
+
+  void bindPipeline(LvePipeline &pipeline) {
+    pipeline.bind(commandBuffer);
+    topology = pipeline.getTopology();
+    counters.pipelineBinds++;
+  }
+
+  void bindDescriptorSets(
+      VkPipelineLayout layout,
+      uint32_t firstSet,
+      uint32_t setCount,
+      const VkDescriptorSet *sets,
+      uint32_t dynamicOffsetCount = 0,
+      const uint32_t *dynamicOffsets = nullptr) {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+    counters.descriptorSetBinds += setCount;
+  }
+
+  void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *values) {
+    vkCmdPushConstants(commandBuffer, layout, stages, offset, size, values);
+    counters.pushConstantBytes += size;
+  }
+
+  void bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *buffers, const VkDeviceSize *offsets) {
+    vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, buffers, offsets);
+    counters.bufferBinds += bindingCount;
+  }
+
+  void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+    counters.bufferBinds++;
+  }
+
+  void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+    vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    counters.drawCalls++;
+    counters.triangles += trianglesFor(vertexCount) * instanceCount;
+  }
+
+  void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    counters.drawCalls++;
+    counters.triangles += trianglesFor(indexCount) * instanceCount;
+  }
+
+  // the draw count lives on the gpu, so this counts one call and no triangles
+  void drawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount) {
+    vkCmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    counters.drawCalls++;
+  }
+
+ private:
+  uint64_t trianglesFor(uint32_t vertexCount) const noexcept {
+    switch (topology) {
+      case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST: return vertexCount / 3;
+      case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+      case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN: return vertexCount > 2 ? vertexCount - 2 : 0;
+      default: return 0;
+    }
+  }
+
+  VkCommandBuffer commandBuffer;
+  LveRenderStats &stats;
+  LveDrawCounters counters{};
+  VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+};
+
+}  // namespace lve
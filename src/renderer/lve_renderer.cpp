@@ -1,7 +1,11 @@
 #include "renderer/lve_renderer.hpp"
 
+#include "core/lve_profiler.hpp"
+
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <limits>
 #include <stdexcept>
 
 /**
@@ -14,12 +18,15 @@ namespace lve {
 LveRenderer::LveRenderer(LveWindow& window, LveDevice& device)
     : lveWindow{window}, lveDevice{device} {
   recreateSwapChain();
-  createCommandBuffers();
   createShadowRenderPass();
+  threadPool = std::make_unique<LveThreadPool>(LveThreadPool::defaultThreadCount());
+  createFrameContexts();
+  gpuProfiler_ = std::make_unique<LveGpuProfiler>(lveDevice, MAX_FRAMES_IN_FLIGHT);
+  renderStats_ = std::make_unique<LveRenderStats>(lveDevice, MAX_FRAMES_IN_FLIGHT);
 }
 
 LveRenderer::~LveRenderer() { 
-  freeCommandBuffers(); 
+  destroyFrameContexts();
   vkDestroyRenderPass(lveDevice.device(), shadowRenderPass, nullptr);
   if (shadowFramebuffer != VK_NULL_HANDLE) {
     vkDestroyFramebuffer(lveDevice.device(), shadowFramebuffer, nullptr);
@@ -35,39 +42,119 @@ void LveRenderer::recreateSwapChain() {
   vkDeviceWaitIdle(lveDevice.device());
 
   if (!lveSwapChain) {
-    lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+    lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, presentMode);
   } else {
     std::shared_ptr<LveSwapChain> oldSwapChain = std::move(lveSwapChain);
-    lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
+    lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain, presentMode);
     if (!oldSwapChain->compareSwapFormats(*lveSwapChain)) {
       throw std::runtime_error("swap chain image or depth format has changed");
     }
   }
 }
 
-void LveRenderer::createCommandBuffers() {
-  commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+void LveRenderer::createFrameContexts() {
+  VkSemaphoreTypeCreateInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  timelineInfo.initialValue = 0;
+  VkSemaphoreCreateInfo timelineCreateInfo{};
+  timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  timelineCreateInfo.pNext = &timelineInfo;
+  if (vkCreateSemaphore(lveDevice.device(), &timelineCreateInfo, nullptr, &frameTimeline) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create frame timeline semaphore");
+  }
+
+  uint32_t graphicsFamily = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+  frames.resize(MAX_FRAMES_IN_FLIGHT);
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    auto &frame = frames[i];
+    frame.index = i;
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = lveDevice.getCommandPool();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate command buffers");
+    }
+
+    frame.commandPools.resize(threadPool->getThreadCount() + 1);
+    for (auto &commandPool : frame.commandPools) {
+      VkCommandPoolCreateInfo poolInfo{};
+      poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+      poolInfo.queueFamilyIndex = graphicsFamily;
+      poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+      if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &commandPool.pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create thread command pool");
+      }
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, nullptr, &frame.imageAvailable) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create sync objects");
+    }
+  }
+}
 
-  VkCommandBufferAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.commandPool = lveDevice.getCommandPool();
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+void LveRenderer::destroyFrameContexts() {
+  for (auto &frame : frames) {
+    vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), 1, &frame.commandBuffer);
+    for (auto &commandPool : frame.commandPools) vkDestroyCommandPool(lveDevice.device(), commandPool.pool, nullptr);
+    vkDestroySemaphore(lveDevice.device(), frame.imageAvailable, nullptr);
+  }
+  frames.clear();
+  vkDestroySemaphore(lveDevice.device(), frameTimeline, nullptr);
+}
 
-  if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate command buffers");
+void LveRenderer::waitForFrame(uint64_t timelineValue) {
+  if (timelineValue == 0) return;
+  VkSemaphoreWaitInfo waitInfo{};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &frameTimeline;
+  waitInfo.pValues = &timelineValue;
+  if (vkWaitSemaphores(lveDevice.device(), &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+    throw std::runtime_error("failed to wait for frame timeline");
   }
 }
 
-void LveRenderer::freeCommandBuffers() {
-  vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-  commandBuffers.clear();
+uint64_t LveRenderer::getCompletedFrameNumber() const {
+  uint64_t value = 0;
+  vkGetSemaphoreCounterValue(lveDevice.device(), frameTimeline, &value);
+  return value;
+}
+
+void LveRenderer::setFramesInFlight(uint32_t count) noexcept { framesInFlight = std::clamp(count, 1u, MAX_FRAMES_IN_FLIGHT); }
+
+void LveRenderer::setPresentMode(VkPresentModeKHR mode) noexcept {
+  if (mode == presentMode) return;
+  presentMode = mode;
+  presentModeChanged = true;
 }
 
 VkCommandBuffer LveRenderer::beginFrame() {
   assert(!isFrameStarted && "cannot call beginframe while already in progress");
 
-  auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
+  if (presentModeChanged) {
+    presentModeChanged = false;
+    recreateSwapChain();
+  }
+
+  // frames in flight may have shrunk since this index was picked
+  if (currentFrameIndex >= framesInFlight) currentFrameIndex = 0;
+  auto &frame = frames[currentFrameIndex];
+  {
+    LVE_PROFILE_SCOPE("wait for frame");
+    waitForFrame(frame.submitValue);
+  }
+
+  VkResult result;
+  {
+    LVE_PROFILE_SCOPE("acquire");
+    result = lveSwapChain->acquireNextImage(frame.imageAvailable, &currentImageIndex);
+  }
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
     recreateSwapChain();
     return nullptr;
@@ -77,22 +164,38 @@ VkCommandBuffer LveRenderer::beginFrame() {
 
   isFrameStarted = true;
 
+  // the gpu is done with this context, so its secondaries are free to reuse
+  for (auto &commandPool : frame.commandPools) {
+    vkResetCommandPool(lveDevice.device(), commandPool.pool, 0);
+    commandPool.used = 0;
+  }
+
   auto commandBuffer = getCurrentCommandBuffer();
   VkCommandBufferBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   beginInfo.flags = 0;
   beginInfo.pInheritanceInfo = nullptr;
   if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin recording command buffer");
-  
+
+  gpuProfiler_->beginFrame(commandBuffer, currentFrameIndex);
+  renderStats_->beginFrame(commandBuffer, currentFrameIndex);
+  frameScope = gpuProfiler_->beginScope(commandBuffer, "frame");
   return commandBuffer;
 }
 
 void LveRenderer::endFrame() {
   assert(isFrameStarted && "cannot call endframe while frame is not in progress");
   auto commandBuffer = getCurrentCommandBuffer();
+  gpuProfiler_->writeEnd(commandBuffer, frameScope);
   if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) throw std::runtime_error("failed to record command buffer");
 
-  auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+  LVE_PROFILE_SCOPE("submit and present");
+  // uploads queued during the frame are submitted first so this frame already sees them
+  lveDevice.streamingQueue().flush();
+  lveDevice.uploadQueue().flush();
+  auto &frame = frames[currentFrameIndex];
+  frame.submitValue = ++submittedFrames;
+  auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, frame.imageAvailable, frameTimeline, frame.submitValue);
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()) {
     lveWindow.resetWindowResizedFlag();
     recreateSwapChain();
@@ -101,16 +204,16 @@ void LveRenderer::endFrame() {
   }
 
   isFrameStarted = false;
-  currentFrameIndex = (currentFrameIndex + 1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+  currentFrameIndex = (currentFrameIndex + 1) % framesInFlight;
 }
 
-void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, LveSwapChain::Pass pass) {
   assert(isFrameStarted && "cannot call beginswapchainrenderpass if frame is not in progress");
   assert(commandBuffer == getCurrentCommandBuffer() && "render pass on wrong buffer");
 
   VkRenderPassBeginInfo renderPassInfo{};
   renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassInfo.renderPass = lveSwapChain->getRenderPass();
+  renderPassInfo.renderPass = lveSwapChain->getRenderPass(pass);
   renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
   renderPassInfo.renderArea.offset = {0, 0};
   renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
@@ -121,23 +224,18 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
   renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
   renderPassInfo.pClearValues = clearValues.data();
 
-  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-  VkViewport viewport{};
-  viewport.x = 0.0f;
-  viewport.y = 0.0f;
-  viewport.width = static_cast<float>(lveSwapChain->getSwapChainExtent().width);
-  viewport.height = static_cast<float>(lveSwapChain->getSwapChainExtent().height);
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
-  VkRect2D scissor{{0, 0}, lveSwapChain->getSwapChainExtent()};
-  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+  const char *name = pass == LveSwapChain::Pass::Early ? "main pass early" : (pass == LveSwapChain::Pass::Late ? "main pass late" : "main pass");
+  passScope = gpuProfiler_->beginScope(commandBuffer, name);
+  passStatistics = renderStats_->beginPass(commandBuffer, name);
+  beginPass(commandBuffer, renderPassInfo);
 }
 
 void LveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
   assert(isFrameStarted && "cannot call endswapchainrenderpass if frame is not in progress");
   vkCmdEndRenderPass(commandBuffer);
+  renderStats_->endPass(commandBuffer, passStatistics);
+  gpuProfiler_->writeEnd(commandBuffer, passScope);
+  activePass = ActivePass{};
 }
 
 void LveRenderer::beginShadowRenderPass(VkCommandBuffer commandBuffer, const std::unique_ptr<LveShadowMap>& shadowMap) {
@@ -164,23 +262,101 @@ void LveRenderer::beginShadowRenderPass(VkCommandBuffer commandBuffer, const std
   renderPassInfo.clearValueCount = 1;
   renderPassInfo.pClearValues = &clearValue;
 
-  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-  VkViewport viewport{};
-  viewport.x = 0.0f;
-  viewport.y = 0.0f;
-  viewport.width = static_cast<float>(shadowMap->getWidth());
-  viewport.height = static_cast<float>(shadowMap->getHeight());
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
-  VkRect2D scissor{{0, 0}, {shadowMap->getWidth(), shadowMap->getHeight()}};
-  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+  passScope = gpuProfiler_->beginScope(commandBuffer, "shadow pass");
+  passStatistics = renderStats_->beginPass(commandBuffer, "shadow pass");
+  beginPass(commandBuffer, renderPassInfo);
 }
 
 void LveRenderer::endShadowRenderPass(VkCommandBuffer commandBuffer) {
   assert(isFrameStarted && "cannot call endshadowrenderpass if frame is not in progress");
   vkCmdEndRenderPass(commandBuffer);
+  renderStats_->endPass(commandBuffer, passStatistics);
+  gpuProfiler_->writeEnd(commandBuffer, passScope);
+  activePass = ActivePass{};
+}
+
+void LveRenderer::beginPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo &renderPassInfo) {
+  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+  activePass.renderPass = renderPassInfo.renderPass;
+  activePass.framebuffer = renderPassInfo.framebuffer;
+  activePass.viewport.x = 0.0f;
+  activePass.viewport.y = 0.0f;
+  activePass.viewport.width = static_cast<float>(renderPassInfo.renderArea.extent.width);
+  activePass.viewport.height = static_cast<float>(renderPassInfo.renderArea.extent.height);
+  activePass.viewport.minDepth = 0.0f;
+  activePass.viewport.maxDepth = 1.0f;
+  activePass.scissor = renderPassInfo.renderArea;
+}
+
+VkCommandBuffer LveRenderer::beginSecondaryCommandBuffer(uint32_t thread) {
+  assert(activePass.renderPass != VK_NULL_HANDLE && "secondary command buffers need an active render pass");
+  auto &commandPool = frames[currentFrameIndex].commandPools[thread];
+  if (commandPool.used == commandPool.buffers.size()) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool.pool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer buffer;
+    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &buffer) != VK_SUCCESS) throw std::runtime_error("failed to allocate secondary command buffer");
+    commandPool.buffers.push_back(buffer);
+  }
+  auto commandBuffer = commandPool.buffers[commandPool.used++];
+
+  VkCommandBufferInheritanceInfo inheritance{};
+  inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance.renderPass = activePass.renderPass;
+  inheritance.subpass = 0;
+  inheritance.framebuffer = activePass.framebuffer;
+  inheritance.pipelineStatistics = renderStats_->inheritedStatistics();
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = &inheritance;
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) throw std::runtime_error("failed to begin secondary command buffer");
+
+  vkCmdSetViewport(commandBuffer, 0, 1, &activePass.viewport);
+  vkCmdSetScissor(commandBuffer, 0, 1, &activePass.scissor);
+  return commandBuffer;
+}
+
+void LveRenderer::executeSecondaryCommandBuffers(VkCommandBuffer primary, uint32_t count, const VkCommandBuffer *secondaries) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (vkEndCommandBuffer(secondaries[i]) != VK_SUCCESS) throw std::runtime_error("failed to record secondary command buffer");
+  }
+  vkCmdExecuteCommands(primary, count, secondaries);
+}
+
+void LveRenderer::recordParallel(
+    VkCommandBuffer primary, uint32_t itemCount, const std::function<void(LveCommandRecorder &, uint32_t, uint32_t)> &record, const char *gpuScope) {
+  if (itemCount == 0) return;
+  uint32_t chunkCount = std::clamp((itemCount + MIN_DRAWS_PER_THREAD - 1) / MIN_DRAWS_PER_THREAD, 1u, getWorkerCount());
+  // the ranges execute in order, so the first one opens the scope and the last one closes it
+  uint32_t scope = gpuScope ? gpuProfiler_->createScope(gpuScope) : LveGpuProfiler::NO_SCOPE;
+
+  auto recordRange = [&](uint32_t chunk, uint32_t thread) {
+    uint64_t begin = static_cast<uint64_t>(itemCount) * chunk / chunkCount;
+    uint64_t end = static_cast<uint64_t>(itemCount) * (chunk + 1) / chunkCount;
+    LVE_PROFILE_SCOPE(gpuScope ? gpuScope : "record range");
+    auto cmd = beginSecondaryCommandBuffer(thread);
+    if (chunk == 0) gpuProfiler_->writeBegin(cmd, scope);
+    {
+      LveCommandRecorder recorder{cmd, *renderStats_};
+      record(recorder, static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+    }
+    if (chunk == chunkCount - 1) gpuProfiler_->writeEnd(cmd, scope);
+    return cmd;
+  };
+
+  std::vector<VkCommandBuffer> secondaries(chunkCount);
+  if (chunkCount == 1) {
+    secondaries[0] = recordRange(0, getMainThreadIndex());
+  } else {
+    threadPool->run(chunkCount, [&](uint32_t chunk, uint32_t worker) { secondaries[chunk] = recordRange(chunk, worker); });
+  }
+  executeSecondaryCommandBuffers(primary, chunkCount, secondaries.data());
 }
 
 void LveRenderer::createShadowRenderPass() {
@@ -1,23 +1,37 @@
 #pragma once
 
 #include "core/lve_device.hpp"
+#include "core/lve_thread_pool.hpp"
 #include "renderer/lve_swap_chain.hpp"
 #include "core/lve_window.hpp"
+#include "renderer/lve_frame_context.hpp"
+#include "renderer/lve_gpu_profiler.hpp"
+#include "renderer/lve_render_stats.hpp"
 #include "renderer/lve_shadow_map.hpp"
 
 #include <cassert>
+#include <functional>
 #include <memory>
 #include <vector>
 
 /**
  * high level renderer class.
- * manages the swap chain lifecycle and frame synchronization.
+ * manages the swap chain lifecycle and frame synchronization. every submission signals the next
+ * value of one timeline semaphore; a frame context is reused once the value its last submission
+ * signalled is reached, so frames in flight can be changed between any two frames.
+ * render passes are begun with secondary command buffer contents, everything inside a pass is
+ * recorded into secondaries from per-thread, per-frame command pools and executed in order.
+ * the gpu profiler times the whole frame and each pass; systems add their own scopes.
+ * render stats count what the systems record and query pipeline statistics per pass.
  */
 
 namespace lve {
 
 class LveRenderer {
  public:
+  static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+  static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
   LveRenderer(LveWindow &window, LveDevice &device);
   ~LveRenderer();
 
@@ -30,30 +44,102 @@ class LveRenderer {
 
   VkCommandBuffer getCurrentCommandBuffer() const {
     assert(isFrameStarted && "cannot get command buffer when frame not in progress");
-    return commandBuffers[currentFrameIndex];
+    return frames[currentFrameIndex].commandBuffer;
   }
 
   int getFrameIndex() const {
     assert(isFrameInProgress() && "cannot get frame index when frame not in progress");
-    return currentFrameIndex;
+    return static_cast<int>(currentFrameIndex);
+  }
+
+  LveFrameContext &getCurrentFrameContext() {
+    assert(isFrameInProgress() && "cannot get frame context when frame not in progress");
+    return frames[currentFrameIndex];
   }
 
+  // all MAX_FRAMES_IN_FLIGHT contexts, for creating per-frame resources up front
+  std::vector<LveFrameContext> &getFrameContexts() noexcept { return frames; }
+
+  /**
+   * 1 keeps the cpu at most one frame ahead (lowest latency), 3 lets it run furthest ahead
+   * (highest throughput). takes effect with the next frame, clamped to [1, MAX_FRAMES_IN_FLIGHT].
+   */
+  void setFramesInFlight(uint32_t count) noexcept;
+  uint32_t getFramesInFlight() const noexcept { return framesInFlight; }
+
+  /**
+   * requests a presentation mode, the swap chain is rebuilt with it at the start of the next frame.
+   * unsupported modes fall back to fifo, getPresentMode() reports the mode actually in use.
+   */
+  void setPresentMode(VkPresentModeKHR mode) noexcept;
+  VkPresentModeKHR getPresentMode() const noexcept { return lveSwapChain->getPresentMode(); }
+
+  // timeline value the frame being recorded signals once the gpu has finished it
+  uint64_t getFrameNumber() const noexcept { return submittedFrames + 1; }
+  // every frame up to this timeline value has finished on the gpu
+  uint64_t getCompletedFrameNumber() const;
+
   VkExtent2D getSwapChainExtent() const noexcept { return lveSwapChain->getSwapChainExtent(); }
 
   VkCommandBuffer beginFrame();
   void endFrame();
 
-  void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+  // split passes run early, then late, with depth reading work recorded between them on the primary
+  void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, LveSwapChain::Pass pass = LveSwapChain::Pass::Whole);
   void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+  // the depth attachment of the image being rendered, shader readable between an early and a late pass
+  VkImageView getDepthImageView() const noexcept { return lveSwapChain->getDepthImageView(currentImageIndex); }
   
   void beginShadowRenderPass(VkCommandBuffer commandBuffer, const std::unique_ptr<LveShadowMap>& shadowMap);
   void endShadowRenderPass(VkCommandBuffer commandBuffer);
 
   VkRenderPass getShadowRenderPass() const noexcept { return shadowRenderPass; }
 
+  /**
+   * begins a secondary command buffer that continues the active render pass, with viewport and
+   * scissor already set. thread selects the command pool and must be the calling thread's
+   * worker index, or getMainThreadIndex() outside of the thread pool.
+   */
+  VkCommandBuffer beginSecondaryCommandBuffer(uint32_t thread);
+  VkCommandBuffer beginSecondaryCommandBuffer() { return beginSecondaryCommandBuffer(getMainThreadIndex()); }
+  void executeSecondaryCommandBuffers(VkCommandBuffer primary, uint32_t count, const VkCommandBuffer *secondaries);
+
+  /**
+   * splits [0, itemCount) into contiguous ranges recorded by the worker threads, each into its own
+   * secondary buffer, and executes them on primary in range order so draw order is preserved.
+   * small lists stay on the calling thread. each range records through its own LveCommandRecorder.
+   */
+  void recordParallel(
+      VkCommandBuffer primary,
+      uint32_t itemCount,
+      const std::function<void(LveCommandRecorder &, uint32_t, uint32_t)> &record,
+      const char *gpuScope = nullptr);
+
+  LveGpuProfiler &gpuProfiler() const noexcept { return *gpuProfiler_; }
+  LveRenderStats &renderStats() const noexcept { return *renderStats_; }
+
+  // shared with cpu side frame work that runs outside of recordParallel, e.g. transform updates
+  LveThreadPool &workerPool() const noexcept { return *threadPool; }
+  uint32_t getWorkerCount() const noexcept { return threadPool->getThreadCount(); }
+  uint32_t getMainThreadIndex() const noexcept { return threadPool->getThreadCount(); }
+
  private:
-  void createCommandBuffers();
-  void freeCommandBuffers();
+  // draws per secondary buffer below which splitting costs more than it saves
+  static constexpr uint32_t MIN_DRAWS_PER_THREAD = 128;
+
+  // state secondaries need to continue the pass, none of it is inherited from the primary
+  struct ActivePass {
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkViewport viewport{};
+    VkRect2D scissor{};
+  };
+
+  void createFrameContexts();
+  void destroyFrameContexts();
+  void waitForFrame(uint64_t timelineValue);
+  void beginPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo &renderPassInfo);
+
   void recreateSwapChain();
   void createShadowRenderPass();
   void createShadowFramebuffer(const std::unique_ptr<LveShadowMap>& shadowMap);
@@ -61,13 +147,28 @@ class LveRenderer {
   LveWindow &lveWindow;
   LveDevice &lveDevice;
   std::unique_ptr<LveSwapChain> lveSwapChain;
-  std::vector<VkCommandBuffer> commandBuffers;
+
+  std::unique_ptr<LveThreadPool> threadPool;
+  std::vector<LveFrameContext> frames;
+  uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+  // fifo never renders frames that are not shown, the other modes trade that for latency
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+  bool presentModeChanged = false;
+  VkSemaphore frameTimeline = VK_NULL_HANDLE;
+  uint64_t submittedFrames = 0;
+  ActivePass activePass{};
+
+  std::unique_ptr<LveGpuProfiler> gpuProfiler_;
+  uint32_t frameScope = LveGpuProfiler::NO_SCOPE;
+  uint32_t passScope = LveGpuProfiler::NO_SCOPE;
+  std::unique_ptr<LveRenderStats> renderStats_;
+  uint32_t passStatistics = LveRenderStats::NO_PASS;
 
   VkRenderPass shadowRenderPass;
   VkFramebuffer shadowFramebuffer = VK_NULL_HANDLE;
 
   uint32_t currentImageIndex;
-  int currentFrameIndex{0};
+  uint32_t currentFrameIndex{0};
   bool isFrameStarted{false};
 };
 }  // namespace lve
@@ -32,7 +32,7 @@ LveShadowMap::LveShadowMap(LveDevice &device, uint32_t w, uint32_t h)
   info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowImage, shadowImageMemory);
+  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowImage, shadowImageAllocation, LveMemoryTag::ShadowMap);
 
   VkImageViewCreateInfo viewInfo{};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -73,8 +73,7 @@ LveShadowMap::LveShadowMap(LveDevice &device, uint32_t w, uint32_t h)
 LveShadowMap::~LveShadowMap() {
   vkDestroySampler(lveDevice.device(), shadowSampler, nullptr);
   vkDestroyImageView(lveDevice.device(), shadowImageView, nullptr);
-  vkDestroyImage(lveDevice.device(), shadowImage, nullptr);
-  vkFreeMemory(lveDevice.device(), shadowImageMemory, nullptr);
+  lveDevice.destroyImage(shadowImage, shadowImageAllocation);
 }
 
 }  // namespace lve
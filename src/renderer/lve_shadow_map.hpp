@@ -28,7 +28,7 @@ class LveShadowMap {
   LveDevice &lveDevice;
   
   VkImage shadowImage = VK_NULL_HANDLE;
-  VkDeviceMemory shadowImageMemory = VK_NULL_HANDLE;
+  LveAllocation shadowImageAllocation{};
   VkImageView shadowImageView = VK_NULL_HANDLE;
   VkSampler shadowSampler = VK_NULL_HANDLE;
   VkFormat shadowFormat;
@@ -4,34 +4,48 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
 
 /**
  * vulkan swap chain abstraction.
- * handles image acquisition, presentation, and synchronization objects.
+ * handles image acquisition and presentation. frame pacing lives in the renderer: it hands in the
+ * frame's acquire semaphore and the timeline value its submission signals.
  */
 
 namespace lve {
 
 class LveSwapChain {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent);
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
+  /**
+   * the main pass in one go, or split around work that reads its depth buffer in between. early
+   * clears and leaves depth readable by compute shaders, late loads both attachments and presents.
+   * all three are compatible, so pipelines and framebuffers work with any of them.
+   */
+  enum class Pass { Whole, Early, Late };
+
+  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_FIFO_KHR);
+  LveSwapChain(
+      LveDevice &deviceRef,
+      VkExtent2D windowExtent,
+      std::shared_ptr<LveSwapChain> previous,
+      VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_FIFO_KHR);
   ~LveSwapChain();
 
   LveSwapChain(const LveSwapChain &) = delete;
   LveSwapChain &operator=(const LveSwapChain &) = delete;
 
   VkFramebuffer getFrameBuffer(int index) const noexcept { return swapChainFramebuffers[index]; }
-  VkRenderPass getRenderPass() const noexcept { return renderPass; }
+  VkRenderPass getRenderPass(Pass pass = Pass::Whole) const noexcept { return renderPasses[static_cast<size_t>(pass)]; }
   VkImageView getImageView(int index) const noexcept { return swapChainImageViews[index]; }
+  VkImageView getDepthImageView(int index) const noexcept { return depthImageViews[index]; }
   size_t imageCount() const noexcept { return swapChainImages.size(); }
   VkFormat getSwapChainImageFormat() const noexcept { return swapChainImageFormat; }
   VkExtent2D getSwapChainExtent() const noexcept { return swapChainExtent; }
+  // the mode in use, fifo when the preferred one is not supported by the surface
+  VkPresentModeKHR getPresentMode() const noexcept { return presentMode; }
   uint32_t width() const noexcept { return swapChainExtent.width; }
   uint32_t height() const noexcept { return swapChainExtent.height; }
 
@@ -40,20 +54,26 @@ class LveSwapChain {
   }
   VkFormat findDepthFormat();
 
-  VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  VkResult acquireNextImage(VkSemaphore imageAvailable, uint32_t *imageIndex);
+  VkResult submitCommandBuffers(
+      const VkCommandBuffer *buffers, uint32_t *imageIndex, VkSemaphore imageAvailable, VkSemaphore timeline, uint64_t signalValue);
 
   bool compareSwapFormats(const LveSwapChain &swapChain) const noexcept {
     return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
            swapChain.swapChainImageFormat == swapChainImageFormat;
   }
 
+  // lowercase names as accepted by parsePresentMode: fifo, fifo_relaxed, mailbox, immediate
+  static const char *presentModeName(VkPresentModeKHR mode) noexcept;
+  static bool parsePresentMode(const std::string &name, VkPresentModeKHR &mode) noexcept;
+
  private:
   void init();
   void createSwapChain();
   void createImageViews();
   void createDepthResources();
-  void createRenderPass();
+  void createRenderPasses();
+  VkRenderPass createRenderPass(Pass pass);
   void createFramebuffers();
   void createSyncObjects();
 
@@ -64,12 +84,14 @@ class LveSwapChain {
   VkFormat swapChainImageFormat;
   VkFormat swapChainDepthFormat;
   VkExtent2D swapChainExtent;
+  VkPresentModeKHR preferredPresentMode;
+  VkPresentModeKHR presentMode;
 
   std::vector<VkFramebuffer> swapChainFramebuffers;
-  VkRenderPass renderPass;
+  std::array<VkRenderPass, 3> renderPasses{};
 
   std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
+  std::vector<LveAllocation> depthImageAllocations;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
@@ -80,11 +102,7 @@ class LveSwapChain {
   VkSwapchainKHR swapChain;
   std::shared_ptr<LveSwapChain> oldSwapChain;
 
-  std::vector<VkSemaphore> imageAvailableSemaphores;
   std::vector<VkSemaphore> renderFinishedSemaphores;
-  std::vector<VkFence> inFlightFences;
-  std::vector<VkFence> imagesInFlight;
-  size_t currentFrame = 0;
 };
 
 }  // namespace lve
@@ -34,15 +34,6 @@ void LveTexture::createTexture(int tw, int th, const uint8_t* pixels) {
   mipLevels = 1;
 
   VkDeviceSize size = width * height * 4;
-  VkBuffer staging;
-  VkDeviceMemory stagingMem;
-  lveDevice.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMem);
-
-  void *data;
-  vkMapMemory(lveDevice.device(), stagingMem, 0, size, 0, &data);
-  std::memcpy(data, pixels, size);
-  vkUnmapMemory(lveDevice.device(), stagingMem);
-
   imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
   VkImageCreateInfo info{};
   info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -59,16 +50,12 @@ void LveTexture::createTexture(int tw, int th, const uint8_t* pixels) {
   info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation, LveMemoryTag::Texture);
 
-  transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-  copyBufferToImage(staging, width, height);
-  transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  // pixels are copied into the staging ring here, the transfer itself lands with the next flush
+  lveDevice.streamingQueue().enqueueImageUpload(image, pixels, size, width, height, VK_IMAGE_LAYOUT_UNDEFINED);
   imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-  vkDestroyBuffer(lveDevice.device(), staging, nullptr);
-  vkFreeMemory(lveDevice.device(), stagingMem, nullptr);
-
   VkImageViewCreateInfo viewInfo{};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
   viewInfo.image = image;
@@ -104,56 +91,7 @@ void LveTexture::createTexture(int tw, int th, const uint8_t* pixels) {
 LveTexture::~LveTexture() {
   vkDestroySampler(lveDevice.device(), sampler, nullptr);
   vkDestroyImageView(lveDevice.device(), imageView, nullptr);
-  vkDestroyImage(lveDevice.device(), image, nullptr);
-  vkFreeMemory(lveDevice.device(), imageMemory, nullptr);
-}
-
-void LveTexture::transitionImageLayout(VkImageLayout oldL, VkImageLayout newL) {
-  auto cmd = lveDevice.beginSingleTimeCommands();
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = oldL;
-  barrier.newLayout = newL;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image = image;
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-
-  VkPipelineStageFlags srcS, dstS;
-  if (oldL == VK_IMAGE_LAYOUT_UNDEFINED && newL == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    srcS = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    dstS = VK_PIPELINE_STAGE_TRANSFER_BIT;
-  } else if (oldL == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newL == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    srcS = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    dstS = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  } else throw std::invalid_argument("unsupported layout transition");
-
-  vkCmdPipelineBarrier(cmd, srcS, dstS, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-  lveDevice.endSingleTimeCommands(cmd);
-}
-
-void LveTexture::copyBufferToImage(VkBuffer buffer, uint32_t w, uint32_t h) {
-  auto cmd = lveDevice.beginSingleTimeCommands();
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = {w, h, 1};
-  vkCmdCopyBufferToImage(cmd, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-  lveDevice.endSingleTimeCommands(cmd);
+  lveDevice.destroyImage(image, imageAllocation);
 }
 
 }  // namespace lve
@@ -27,12 +27,10 @@ class LveTexture {
 
  private:
   void createTexture(int width, int height, const uint8_t* pixels);
-  void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
-  void copyBufferToImage(VkBuffer buffer, uint32_t width, uint32_t height);
 
   LveDevice &lveDevice;
   VkImage image = VK_NULL_HANDLE;
-  VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+  LveAllocation imageAllocation{};
   VkImageView imageView = VK_NULL_HANDLE;
   VkSampler sampler = VK_NULL_HANDLE;
   VkFormat imageFormat;
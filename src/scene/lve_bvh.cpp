@@ -0,0 +1,255 @@
+#include "scene/lve_bvh.hpp"
+
+#include <cmath>
+
+/**
+ * dynamic bvh implementation.
+ * insertion walks down picking the child whose box grows the least (surface area heuristic with
+ * inherited cost, as in box2d's dynamic tree), then refits the ancestors. node indices are stable,
+ * so leaf ids double as proxies.
+ */
+
+namespace lve {
+
+namespace {
+
+LveAabb fatten(const LveAabb &box) {
+  glm::vec3 margin = (box.max - box.min) * LveDynamicBvh::FAT_RATIO + glm::vec3(LveDynamicBvh::FAT_MARGIN);
+  return {box.min - margin, box.max + margin};
+}
+
+}  // namespace
+
+void LveAabb::transformCenterExtent(const glm::mat4 &m, glm::vec3 &center, glm::vec3 &extent) noexcept {
+  const glm::vec3 c = center;
+  const glm::vec3 e = extent;
+  center = {
+      m[0][0] * c.x + m[1][0] * c.y + m[2][0] * c.z + m[3][0],
+      m[0][1] * c.x + m[1][1] * c.y + m[2][1] * c.z + m[3][1],
+      m[0][2] * c.x + m[1][2] * c.y + m[2][2] * c.z + m[3][2]};
+  extent = {
+      std::fabs(m[0][0]) * e.x + std::fabs(m[1][0]) * e.y + std::fabs(m[2][0]) * e.z,
+      std::fabs(m[0][1]) * e.x + std::fabs(m[1][1]) * e.y + std::fabs(m[2][1]) * e.z,
+      std::fabs(m[0][2]) * e.x + std::fabs(m[1][2]) * e.y + std::fabs(m[2][2]) * e.z};
+}
+
+LveAabb LveAabb::transformed(const glm::mat4 &m, const glm::vec3 &localMin, const glm::vec3 &localMax) {
+  glm::vec3 center = (localMin + localMax) * 0.5f;
+  glm::vec3 extent = (localMax - localMin) * 0.5f;
+  transformCenterExtent(m, center, extent);
+  return {center - extent, center + extent};
+}
+
+float LveAabb::intersectRay(const glm::vec3 &origin, const glm::vec3 &invDir, float maxDistance) const noexcept {
+  const glm::vec3 t1 = (min - origin) * invDir;
+  const glm::vec3 t2 = (max - origin) * invDir;
+  const glm::vec3 tLow = glm::min(t1, t2);
+  const glm::vec3 tHigh = glm::max(t1, t2);
+  float tEnter = std::max(std::max(tLow.x, tLow.y), std::max(tLow.z, 0.f));
+  float tExit = std::min(std::min(tHigh.x, tHigh.y), std::min(tHigh.z, maxDistance));
+  return tEnter <= tExit ? tEnter : -1.f;
+}
+
+uint32_t LveDynamicBvh::insert(const LveAabb &box, uint32_t userData) {
+  uint32_t leaf = allocateNode();
+  nodes[leaf].box = fatten(box);
+  nodes[leaf].userData = userData;
+  nodes[leaf].height = 0;
+  insertLeaf(leaf);
+  leafCount++;
+  return leaf;
+}
+
+void LveDynamicBvh::remove(uint32_t proxy) {
+  removeLeaf(proxy);
+  freeNode(proxy);
+  leafCount--;
+}
+
+bool LveDynamicBvh::update(uint32_t proxy, const LveAabb &box) {
+  if (nodes[proxy].box.contains(box)) return false;
+  removeLeaf(proxy);
+  nodes[proxy].box = fatten(box);
+  insertLeaf(proxy);
+  reinsertions++;
+  return true;
+}
+
+uint32_t LveDynamicBvh::allocateNode() {
+  if (freeList == NULL_NODE) {
+    nodes.emplace_back();
+    return static_cast<uint32_t>(nodes.size() - 1);
+  }
+  uint32_t node = freeList;
+  freeList = nodes[node].parent;
+  nodes[node] = Node{};
+  return node;
+}
+
+void LveDynamicBvh::freeNode(uint32_t node) {
+  nodes[node] = Node{};
+  nodes[node].parent = freeList;
+  freeList = node;
+}
+
+void LveDynamicBvh::insertLeaf(uint32_t leaf) {
+  if (root == NULL_NODE) {
+    root = leaf;
+    nodes[leaf].parent = NULL_NODE;
+    return;
+  }
+
+  const LveAabb box = nodes[leaf].box;
+  uint32_t index = root;
+  while (!nodes[index].isLeaf()) {
+    const Node &node = nodes[index];
+    float area = node.box.surfaceArea();
+    float combined = LveAabb::merged(node.box, box).surfaceArea();
+
+    // cost of a new parent here, versus pushing the leaf into either child
+    float cost = 2.f * combined;
+    float inherited = 2.f * (combined - area);
+    auto descendCost = [&](uint32_t child) {
+      float grown = LveAabb::merged(nodes[child].box, box).surfaceArea();
+      return nodes[child].isLeaf() ? grown + inherited : grown - nodes[child].box.surfaceArea() + inherited;
+    };
+    float costLeft = descendCost(node.left);
+    float costRight = descendCost(node.right);
+    if (cost < costLeft && cost < costRight) break;
+    index = costLeft < costRight ? node.left : node.right;
+  }
+
+  uint32_t sibling = index;
+  uint32_t oldParent = nodes[sibling].parent;
+  uint32_t newParent = allocateNode();
+  nodes[newParent].parent = oldParent;
+  nodes[newParent].box = LveAabb::merged(nodes[sibling].box, box);
+  nodes[newParent].height = nodes[sibling].height + 1;
+  nodes[newParent].left = sibling;
+  nodes[newParent].right = leaf;
+  nodes[sibling].parent = newParent;
+  nodes[leaf].parent = newParent;
+
+  if (oldParent == NULL_NODE) {
+    root = newParent;
+  } else if (nodes[oldParent].left == sibling) {
+    nodes[oldParent].left = newParent;
+  } else {
+    nodes[oldParent].right = newParent;
+  }
+  refitFrom(oldParent);
+}
+
+void LveDynamicBvh::removeLeaf(uint32_t leaf) {
+  if (leaf == root) {
+    root = NULL_NODE;
+    return;
+  }
+
+  uint32_t parent = nodes[leaf].parent;
+  uint32_t grandParent = nodes[parent].parent;
+  uint32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+  nodes[sibling].parent = grandParent;
+  if (grandParent == NULL_NODE) {
+    root = sibling;
+  } else {
+    if (nodes[grandParent].left == parent) nodes[grandParent].left = sibling;
+    else nodes[grandParent].right = sibling;
+  }
+  freeNode(parent);
+  refitFrom(grandParent);
+}
+
+void LveDynamicBvh::refitFrom(uint32_t node) {
+  while (node != NULL_NODE) {
+    Node &n = nodes[node];
+    n.box = LveAabb::merged(nodes[n.left].box, nodes[n.right].box);
+    n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+    node = n.parent;
+  }
+}
+
+bool LveDynamicBvh::isDegraded() const noexcept {
+  if (leafCount == 0) return false;
+  if (reinsertions > leafCount) return true;
+  const uint32_t balancedHeight = static_cast<uint32_t>(std::ceil(std::log2(static_cast<float>(leafCount))));
+  return nodes[root].height > 2 * balancedHeight + 1;
+}
+
+void LveDynamicBvh::rebuild() {
+  if (root == NULL_NODE) return;
+
+  // keep the leaves, recycle every internal node
+  std::vector<uint32_t> leaves;
+  leaves.reserve(leafCount);
+  std::vector<uint32_t> stack{root};
+  while (!stack.empty()) {
+    uint32_t node = stack.back();
+    stack.pop_back();
+    if (nodes[node].isLeaf()) {
+      leaves.push_back(node);
+    } else {
+      stack.push_back(nodes[node].left);
+      stack.push_back(nodes[node].right);
+      freeNode(node);
+    }
+  }
+
+  root = buildRange(leaves, 0, static_cast<uint32_t>(leaves.size()));
+  nodes[root].parent = NULL_NODE;
+  reinsertions = 0;
+}
+
+uint32_t LveDynamicBvh::buildRange(std::vector<uint32_t> &leaves, uint32_t begin, uint32_t end) {
+  if (end - begin == 1) return leaves[begin];
+
+  // split at the median centre along the axis the centres spread the most
+  LveAabb centers{};
+  for (uint32_t i = begin; i < end; i++) {
+    glm::vec3 c = nodes[leaves[i]].box.center();
+    centers.min = glm::min(centers.min, c);
+    centers.max = glm::max(centers.max, c);
+  }
+  glm::vec3 spread = centers.max - centers.min;
+  int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+  uint32_t mid = begin + (end - begin) / 2;
+  std::nth_element(leaves.begin() + begin, leaves.begin() + mid, leaves.begin() + end, [&](uint32_t a, uint32_t b) {
+    return nodes[a].box.center()[axis] < nodes[b].box.center()[axis];
+  });
+
+  uint32_t left = buildRange(leaves, begin, mid);
+  uint32_t right = buildRange(leaves, mid, end);
+  uint32_t node = allocateNode();
+  nodes[node].left = left;
+  nodes[node].right = right;
+  nodes[node].box = LveAabb::merged(nodes[left].box, nodes[right].box);
+  nodes[node].height = 1 + std::max(nodes[left].height, nodes[right].height);
+  nodes[left].parent = node;
+  nodes[right].parent = node;
+  return node;
+}
+
+LveDynamicBvh::RayHit LveDynamicBvh::raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance) const {
+  RayHit hit{};
+  hit.distance = maxDistance;
+  if (root == NULL_NODE) return hit;
+  const glm::vec3 invDir = 1.f / dir;
+
+  TraversalStack stack;
+  stack.push(root);
+  while (!stack.empty()) {
+    const Node &node = nodes[stack.pop()];
+    float t = node.box.intersectRay(origin, invDir, hit.distance);
+    if (t < 0.f) continue;
+    if (node.isLeaf()) {
+      hit.distance = t;
+      hit.userData = node.userData;
+    } else {
+      stack.push(node.left);
+      stack.push(node.right);
+    }
+  }
+  return hit;
+}
+
+}  // namespace lve
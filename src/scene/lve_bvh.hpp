@@ -0,0 +1,215 @@
+#pragma once
+
+#include "scene/lve_culling.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * dynamic bounding volume hierarchy over world space boxes.
+ * leaves store slightly enlarged boxes so small motions leave the tree untouched and bigger ones
+ * reinsert the leaf; rebuild() re-splits the whole tree top down once reinsertions have degraded it.
+ * queries walk the tree with an explicit stack and report the user data of every leaf they reach.
+ */
+
+namespace lve {
+
+struct LveAabb {
+  glm::vec3 min{std::numeric_limits<float>::max()};
+  glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+  /** moves a local centre and half extent into world space under an affine matrix, |m| applied to the extent. */
+  static void transformCenterExtent(const glm::mat4 &m, glm::vec3 &center, glm::vec3 &extent) noexcept;
+  /** world box of a local box under an affine matrix. */
+  static LveAabb transformed(const glm::mat4 &m, const glm::vec3 &localMin, const glm::vec3 &localMax);
+  static LveAabb merged(const LveAabb &a, const LveAabb &b) noexcept {
+    return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+  }
+
+  glm::vec3 center() const noexcept { return (min + max) * 0.5f; }
+  float surfaceArea() const noexcept {
+    glm::vec3 d = max - min;
+    return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+  bool contains(const LveAabb &other) const noexcept {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z && max.x >= other.max.x &&
+           max.y >= other.max.y && max.z >= other.max.z;
+  }
+  bool overlaps(const LveAabb &other) const noexcept {
+    return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+  }
+  bool overlapsSphere(const glm::vec3 &center, float radius) const noexcept {
+    glm::vec3 d = glm::max(min - center, glm::max(glm::vec3(0.f), center - max));
+    return d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius;
+  }
+
+  /** entry distance of the ray along dir, or a negative value on a miss. invDir is 1 / dir. */
+  float intersectRay(const glm::vec3 &origin, const glm::vec3 &invDir, float maxDistance) const noexcept;
+};
+
+class LveDynamicBvh {
+ public:
+  static constexpr uint32_t NULL_NODE = std::numeric_limits<uint32_t>::max();
+  // leaf boxes grow by this fraction of their size, plus a small absolute margin
+  static constexpr float FAT_RATIO = 0.1f;
+  static constexpr float FAT_MARGIN = 0.01f;
+
+  struct RayHit {
+    uint32_t userData = NULL_NODE;
+    float distance = std::numeric_limits<float>::max();
+    bool isHit() const noexcept { return userData != NULL_NODE; }
+  };
+
+  /** adds a leaf and returns its proxy id, stable until remove(). */
+  uint32_t insert(const LveAabb &box, uint32_t userData);
+  void remove(uint32_t proxy);
+
+  /** moves a leaf. returns true when the box left the fat box and the leaf had to be reinserted. */
+  bool update(uint32_t proxy, const LveAabb &box);
+
+  /** rebuilds the tree top down by median splits over the leaf centres. proxies stay valid. */
+  void rebuild();
+
+  /**
+   * cheap hint that rebuild() would pay off: reinsertions outnumber the leaves, or the tree grew past
+   * twice the height of a balanced one, as insertion without rotations does after bulk inserts.
+   */
+  bool isDegraded() const noexcept;
+
+  uint32_t getLeafCount() const noexcept { return leafCount; }
+  uint32_t getUserData(uint32_t proxy) const noexcept { return nodes[proxy].userData; }
+  const LveAabb &getFatAabb(uint32_t proxy) const noexcept { return nodes[proxy].box; }
+  uint32_t getHeight() const noexcept { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+  /** fn(userData) for every leaf whose fat box touches the frustum. */
+  template <typename Fn>
+  void queryFrustum(const LveFrustum &frustum, Fn &&fn) const {
+    traverse([&](const LveAabb &box) { return frustum.intersectsAabb(box.min, box.max); }, fn);
+  }
+
+  template <typename Fn>
+  void queryAabb(const LveAabb &query, Fn &&fn) const {
+    traverse([&](const LveAabb &box) { return box.overlaps(query); }, fn);
+  }
+
+  template <typename Fn>
+  void querySphere(const glm::vec3 &center, float radius, Fn &&fn) const {
+    traverse([&](const LveAabb &box) { return box.overlapsSphere(center, radius); }, fn);
+  }
+
+  /**
+   * nearest hit along a ray, dir need not be normalized and distances are in units of dir.
+   * narrowphase(userData, closest) returns the exact hit distance of a leaf or a negative value on
+   * a miss; it is only called for leaves whose box is entered before the closest hit so far.
+   */
+  template <typename Fn>
+  RayHit raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance, Fn &&narrowphase) const {
+    RayHit hit{};
+    hit.distance = maxDistance;
+    if (root == NULL_NODE) return hit;
+    const glm::vec3 invDir = 1.f / dir;
+
+    TraversalStack stack;
+    stack.push(root);
+    while (!stack.empty()) {
+      const Node &node = nodes[stack.pop()];
+      if (node.box.intersectRay(origin, invDir, hit.distance) < 0.f) continue;
+      if (node.isLeaf()) {
+        float t = narrowphase(node.userData, hit.distance);
+        if (t >= 0.f && t < hit.distance) {
+          hit.distance = t;
+          hit.userData = node.userData;
+        }
+        continue;
+      }
+      // push the farther child first so the nearer one is visited first and shrinks the ray
+      float tLeft = nodes[node.left].box.intersectRay(origin, invDir, hit.distance);
+      float tRight = nodes[node.right].box.intersectRay(origin, invDir, hit.distance);
+      uint32_t nearChild = node.left, farChild = node.right;
+      float tNear = tLeft, tFar = tRight;
+      if (tRight >= 0.f && (tLeft < 0.f || tRight < tLeft)) {
+        std::swap(nearChild, farChild);
+        std::swap(tNear, tFar);
+      }
+      if (tFar >= 0.f) stack.push(farChild);
+      if (tNear >= 0.f) stack.push(nearChild);
+    }
+    return hit;
+  }
+
+  /** nearest leaf by fat box entry distance, for callers without a finer shape. */
+  RayHit raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance) const;
+
+ private:
+  struct Node {
+    LveAabb box;
+    uint32_t parent = NULL_NODE;  // next free node while on the free list
+    uint32_t left = NULL_NODE;
+    uint32_t right = NULL_NODE;
+    uint32_t userData = NULL_NODE;
+    uint32_t height = 0;  // 0 for leaves
+
+    bool isLeaf() const noexcept { return left == NULL_NODE; }
+  };
+
+  // lives on the caller's stack so queries can run concurrently and nest, spills past 64 levels
+  class TraversalStack {
+   public:
+    void push(uint32_t node) {
+      if (count < INLINE_CAPACITY) inlineNodes[count] = node;
+      else spill.push_back(node);
+      count++;
+    }
+    uint32_t pop() {
+      count--;
+      if (count < INLINE_CAPACITY) return inlineNodes[count];
+      uint32_t node = spill.back();
+      spill.pop_back();
+      return node;
+    }
+    bool empty() const noexcept { return count == 0; }
+
+   private:
+    static constexpr uint32_t INLINE_CAPACITY = 64;
+    uint32_t inlineNodes[INLINE_CAPACITY];
+    std::vector<uint32_t> spill;
+    uint32_t count = 0;
+  };
+
+  template <typename Test, typename Fn>
+  void traverse(Test &&test, Fn &&fn) const {
+    if (root == NULL_NODE) return;
+    TraversalStack stack;
+    stack.push(root);
+    while (!stack.empty()) {
+      const Node &node = nodes[stack.pop()];
+      if (!test(node.box)) continue;
+      if (node.isLeaf()) {
+        fn(node.userData);
+      } else {
+        stack.push(node.left);
+        stack.push(node.right);
+      }
+    }
+  }
+
+  uint32_t allocateNode();
+  void freeNode(uint32_t node);
+  void insertLeaf(uint32_t leaf);
+  void removeLeaf(uint32_t leaf);
+  void refitFrom(uint32_t node);
+  uint32_t buildRange(std::vector<uint32_t> &leaves, uint32_t begin, uint32_t end);
+
+  std::vector<Node> nodes;
+  uint32_t root = NULL_NODE;
+  uint32_t freeList = NULL_NODE;
+  uint32_t leafCount = 0;
+  uint32_t reinsertions = 0;
+};
+
+}  // namespace lve
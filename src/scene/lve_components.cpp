@@ -0,0 +1,47 @@
+#include "scene/lve_components.hpp"
+
+/**
+ * component implementation.
+ * builds and decomposes the cached matrices of the transform component.
+ */
+
+namespace lve {
+
+bool TransformComponent::updateLocal() {
+  if (!dirty) return false;
+
+  // shared sin/cos for both matrices, the normal matrix is the rotation scaled by 1 / scale
+  const float c3 = glm::cos(rotation.z), s3 = glm::sin(rotation.z);
+  const float c2 = glm::cos(rotation.x), s2 = glm::sin(rotation.x);
+  const float c1 = glm::cos(rotation.y), s1 = glm::sin(rotation.y);
+  const glm::mat3 r{
+      {c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1},
+      {c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3},
+      {c2 * s1, -s2, c1 * c2}};
+  const glm::vec3 invScale = 1.0f / scale;
+
+  localMatrix = glm::mat4{
+      glm::vec4{scale.x * r[0], 0.f},
+      glm::vec4{scale.y * r[1], 0.f},
+      glm::vec4{scale.z * r[2], 0.f},
+      glm::vec4{translation, 1.f}};
+  localNormal = glm::mat3{invScale.x * r[0], invScale.y * r[1], invScale.z * r[2]};
+  dirty = false;
+  return true;
+}
+
+void TransformComponent::setFromMatrix(const glm::mat4 &matrix) {
+  translation = glm::vec3{matrix[3]};
+  scale = {glm::length(glm::vec3{matrix[0]}), glm::length(glm::vec3{matrix[1]}), glm::length(glm::vec3{matrix[2]})};
+
+  // inverse of the yxz rotation built in updateLocal, read off the normalized basis
+  const glm::vec3 x = glm::vec3{matrix[0]} / scale.x;
+  const glm::vec3 y = glm::vec3{matrix[1]} / scale.y;
+  const glm::vec3 z = glm::vec3{matrix[2]} / scale.z;
+  rotation.x = glm::asin(glm::clamp(-z.y, -1.f, 1.f));
+  rotation.y = glm::atan(z.x, z.z);
+  rotation.z = glm::atan(x.y, y.y);
+  dirty = true;
+}
+
+}  // namespace lve
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "scene/lve_model.hpp"
+#include "renderer/lve_texture.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <string>
+
+/**
+ * scene components.
+ * plain data held by value in the scene's component pools, one pool per type.
+ */
+
+namespace lve {
+
+/**
+ * local translation, tait-bryan yxz rotation and scale, relative to the parent entity if any,
+ * with cached local and world matrices.
+ * setters only flag the transform dirty; the scene's update pass rebuilds the matrices once per
+ * change, so objects that never move never pay for the trig again.
+ */
+class TransformComponent {
+ public:
+  const glm::vec3 &getTranslation() const noexcept { return translation; }
+  const glm::vec3 &getRotation() const noexcept { return rotation; }
+  const glm::vec3 &getScale() const noexcept { return scale; }
+
+  void setTranslation(const glm::vec3 &value) noexcept {
+    translation = value;
+    dirty = true;
+  }
+  void setRotation(const glm::vec3 &value) noexcept {
+    rotation = value;
+    dirty = true;
+  }
+  void setScale(const glm::vec3 &value) noexcept {
+    scale = value;
+    dirty = true;
+  }
+
+  /** decomposes an affine matrix without shear, e.g. a gltf node matrix, into the local trs. */
+  void setFromMatrix(const glm::mat4 &matrix);
+
+  bool isDirty() const noexcept { return dirty; }
+
+  /** world model and normal matrices, parent world times local, as of the last scene update. */
+  const glm::mat4 &mat4() const noexcept { return worldMatrix; }
+  const glm::mat3 &normalMatrix() const noexcept { return worldNormal; }
+  const glm::mat4 &getLocalMatrix() const noexcept { return localMatrix; }
+  // bumped whenever the world matrices change, so caches of them can tell when they went stale
+  uint32_t getWorldVersion() const noexcept { return worldVersion; }
+
+ private:
+  friend class LveScene;
+
+  /** rebuilds the local matrices if anything changed since the last call. returns whether it did. */
+  bool updateLocal();
+  void markDirty() noexcept { dirty = true; }
+
+  glm::vec3 translation{};
+  glm::vec3 scale{1.f, 1.f, 1.f};
+  glm::vec3 rotation{};
+
+  glm::mat4 localMatrix{1.f};
+  glm::mat3 localNormal{1.f};
+  glm::mat4 worldMatrix{1.f};
+  glm::mat3 worldNormal{1.f};
+  uint32_t worldVersion = 0;
+  bool dirty = true;
+};
+
+struct MeshComponent {
+  std::shared_ptr<LveModel> model{};
+};
+
+struct MaterialComponent {
+  std::shared_ptr<LveTexture> diffuseMap{};
+  VkDescriptorSet textureDescriptorSet = VK_NULL_HANDLE;
+  glm::vec2 uvScale{1.f, 1.f};
+};
+
+// the billboard radius is the owner's transform scale.x
+struct PointLightComponent {
+  glm::vec3 color{1.f};
+  float lightIntensity = 1.0f;
+};
+
+struct NameComponent {
+  std::string name{};
+};
+
+}  // namespace lve
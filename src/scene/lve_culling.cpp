@@ -0,0 +1,172 @@
+#include "scene/lve_culling.hpp"
+
+#include "scene/lve_scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LVE_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LVE_CULL_SSE2
+#endif
+
+/**
+ * frustum culling implementation.
+ * a box is outside when it lies entirely behind one plane, i.e. when its centre distance plus
+ * its extent projected onto the plane normal is negative.
+ */
+
+namespace lve {
+
+LveFrustum LveFrustum::fromMatrix(const glm::mat4 &m) {
+  // rows of the column major matrix
+  const glm::vec4 r0{m[0][0], m[1][0], m[2][0], m[3][0]};
+  const glm::vec4 r1{m[0][1], m[1][1], m[2][1], m[3][1]};
+  const glm::vec4 r2{m[0][2], m[1][2], m[2][2], m[3][2]};
+  const glm::vec4 r3{m[0][3], m[1][3], m[2][3], m[3][3]};
+
+  LveFrustum frustum{};
+  frustum.planes[0] = r3 + r0;  // left
+  frustum.planes[1] = r3 - r0;  // right
+  frustum.planes[2] = r3 + r1;  // top in vulkan's y down clip space
+  frustum.planes[3] = r3 - r1;  // bottom
+  frustum.planes[4] = r2;       // near, depth 0
+  frustum.planes[5] = r3 - r2;  // far, depth 1
+  for (auto &plane : frustum.planes) {
+    float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    plane = plane * (1.f / length);
+  }
+  return frustum;
+}
+
+bool LveFrustum::intersectsAabb(const glm::vec3 &min, const glm::vec3 &max) const noexcept {
+  const glm::vec3 center = (min + max) * 0.5f;
+  const glm::vec3 extent = (max - min) * 0.5f;
+  for (const auto &p : planes) {
+    float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+    float radius = std::fabs(p.x) * extent.x + std::fabs(p.y) * extent.y + std::fabs(p.z) * extent.z;
+    if (distance + radius < 0.f) return false;
+  }
+  return true;
+}
+
+void LveFrustumCuller::updateBounds(const LveScene &scene) {
+  const auto &meshes = scene.pool<MeshComponent>();
+  const auto &transforms = scene.pool<TransformComponent>();
+  const uint32_t count = meshes.size();
+  for (auto *array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) array->resize(count);
+
+  for (uint32_t slot = 0; slot < count; slot++) {
+    const auto &box = meshes.at(slot).model->getBoundingBox();
+    glm::vec3 c = (box.min + box.max) * 0.5f;
+    glm::vec3 e = (box.max - box.min) * 0.5f;
+    LveAabb::transformCenterExtent(transforms.find(meshes.ownerAt(slot))->mat4(), c, e);
+    centerX[slot] = c.x;
+    centerY[slot] = c.y;
+    centerZ[slot] = c.z;
+    extentX[slot] = e.x;
+    extentY[slot] = e.y;
+    extentZ[slot] = e.z;
+  }
+}
+
+LveCullStats LveFrustumCuller::cull(const LveFrustum &frustum, std::vector<uint32_t> &visible) const {
+  const uint32_t count = size();
+  visible.clear();
+  uint32_t slot = 0;
+
+#if defined(LVE_CULL_AVX)
+  for (; slot + 8 <= count; slot += 8) {
+    const __m256 cx = _mm256_loadu_ps(&centerX[slot]), cy = _mm256_loadu_ps(&centerY[slot]), cz = _mm256_loadu_ps(&centerZ[slot]);
+    const __m256 ex = _mm256_loadu_ps(&extentX[slot]), ey = _mm256_loadu_ps(&extentY[slot]), ez = _mm256_loadu_ps(&extentZ[slot]);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const auto &p : frustum.planes) {
+      __m256 d = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(p.x)), _mm256_mul_ps(cy, _mm256_set1_ps(p.y))),
+          _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(p.z)), _mm256_set1_ps(p.w)));
+      __m256 r = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::fabs(p.x))), _mm256_mul_ps(ey, _mm256_set1_ps(std::fabs(p.y)))),
+          _mm256_mul_ps(ez, _mm256_set1_ps(std::fabs(p.z))));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+      if (_mm256_movemask_ps(inside) == 0) break;
+    }
+    int mask = _mm256_movemask_ps(inside);
+    for (uint32_t lane = 0; lane < 8; lane++) {
+      if (mask & (1 << lane)) visible.push_back(slot + lane);
+    }
+  }
+#elif defined(LVE_CULL_SSE2)
+  for (; slot + 4 <= count; slot += 4) {
+    const __m128 cx = _mm_loadu_ps(&centerX[slot]), cy = _mm_loadu_ps(&centerY[slot]), cz = _mm_loadu_ps(&centerZ[slot]);
+    const __m128 ex = _mm_loadu_ps(&extentX[slot]), ey = _mm_loadu_ps(&extentY[slot]), ez = _mm_loadu_ps(&extentZ[slot]);
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (const auto &p : frustum.planes) {
+      __m128 d = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(p.x)), _mm_mul_ps(cy, _mm_set1_ps(p.y))),
+          _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+      __m128 r = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::fabs(p.x))), _mm_mul_ps(ey, _mm_set1_ps(std::fabs(p.y)))),
+          _mm_mul_ps(ez, _mm_set1_ps(std::fabs(p.z))));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+      if (_mm_movemask_ps(inside) == 0) break;
+    }
+    int mask = _mm_movemask_ps(inside);
+    for (uint32_t lane = 0; lane < 4; lane++) {
+      if (mask & (1 << lane)) visible.push_back(slot + lane);
+    }
+  }
+#endif
+
+  // the tail that does not fill a batch, and everything on targets without simd
+  for (; slot < count; slot++) {
+    bool inside = true;
+    for (const auto &p : frustum.planes) {
+      float d = p.x * centerX[slot] + p.y * centerY[slot] + p.z * centerZ[slot] + p.w;
+      float r = std::fabs(p.x) * extentX[slot] + std::fabs(p.y) * extentY[slot] + std::fabs(p.z) * extentZ[slot];
+      if (d + r < 0.f) {
+        inside = false;
+        break;
+      }
+    }
+    if (inside) visible.push_back(slot);
+  }
+
+  LveCullStats stats{};
+  stats.visible = static_cast<uint32_t>(visible.size());
+  stats.culled = count - stats.visible;
+  return stats;
+}
+
+LveCullStats LveFrustumCuller::cullShadowCasters(const LveFrustum &lightFrustum, const glm::mat4 &lightView,
+    const std::vector<uint32_t> &receivers, std::vector<uint32_t> &casters) const {
+  cull(lightFrustum, casters);
+
+  // the light looks down -z of its view space, so shadows extend towards smaller z
+  glm::vec3 receiverMin{std::numeric_limits<float>::max()};
+  glm::vec3 receiverMax{std::numeric_limits<float>::lowest()};
+  for (uint32_t slot : receivers) {
+    glm::vec3 center = getCenter(slot), extent = getExtent(slot);
+    LveAabb::transformCenterExtent(lightView, center, extent);
+    receiverMin = glm::min(receiverMin, center - extent);
+    receiverMax = glm::max(receiverMax, center + extent);
+  }
+
+  auto unseen = std::remove_if(casters.begin(), casters.end(), [&](uint32_t slot) {
+    glm::vec3 center = getCenter(slot), extent = getExtent(slot);
+    LveAabb::transformCenterExtent(lightView, center, extent);
+    const glm::vec3 min = center - extent, max = center + extent;
+    return min.x > receiverMax.x || max.x < receiverMin.x || min.y > receiverMax.y || max.y < receiverMin.y || max.z < receiverMin.z;
+  });
+  casters.erase(unseen, casters.end());
+
+  LveCullStats stats{};
+  stats.visible = static_cast<uint32_t>(casters.size());
+  stats.culled = size() - stats.visible;
+  return stats;
+}
+
+}  // namespace lve
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * view frustum culling.
+ * mesh bounds are kept as world space centre/extent arrays and tested against the frustum
+ * planes several boxes at a time, sse2 by default and avx when the build enables it.
+ * shadow casters reuse the same bounds against the light volume, then against the visible receivers.
+ */
+
+namespace lve {
+
+class LveScene;
+
+struct LveFrustum {
+  // xyz is the inward facing unit normal, w the distance, so inside means dot(n, p) + w >= 0
+  glm::vec4 planes[6];
+
+  /** extracts the planes of a vulkan style (0..1 depth) projection * view matrix. */
+  static LveFrustum fromMatrix(const glm::mat4 &projectionView);
+
+  bool intersectsAabb(const glm::vec3 &min, const glm::vec3 &max) const noexcept;
+};
+
+struct LveCullStats {
+  uint32_t visible = 0;
+  uint32_t culled = 0;
+  // inside the frustum but hidden behind the depth pyramid, only the gpu culler tests occlusion
+  uint32_t occluded = 0;
+};
+
+class LveFrustumCuller {
+ public:
+  /** refreshes the world space box of every mesh, indexed by mesh pool slot. */
+  void updateBounds(const LveScene &scene);
+
+  /** replaces visible with the mesh pool slots whose box touches the frustum, in slot order. */
+  LveCullStats cull(const LveFrustum &frustum, std::vector<uint32_t> &visible) const;
+
+  /**
+   * replaces casters with the mesh slots inside the light frustum whose shadow can fall on one of the
+   * receivers, usually the camera visible slots. lightView must be the directional light's view
+   * matrix; a caster is kept when its light space footprint overlaps the receivers' and it is not
+   * entirely behind all of them.
+   */
+  LveCullStats cullShadowCasters(const LveFrustum &lightFrustum, const glm::mat4 &lightView, const std::vector<uint32_t> &receivers,
+      std::vector<uint32_t> &casters) const;
+
+  uint32_t size() const noexcept { return static_cast<uint32_t>(centerX.size()); }
+  glm::vec3 getCenter(uint32_t slot) const noexcept { return {centerX[slot], centerY[slot], centerZ[slot]}; }
+  glm::vec3 getExtent(uint32_t slot) const noexcept { return {extentX[slot], extentY[slot], extentZ[slot]}; }
+
+ private:
+  std::vector<float> centerX, centerY, centerZ;
+  std::vector<float> extentX, extentY, extentZ;
+};
+
+}  // namespace lve
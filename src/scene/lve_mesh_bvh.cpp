@@ -0,0 +1,211 @@
+#include "scene/lve_mesh_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+/**
+ * triangle bvh implementation.
+ * each split bins the triangle centres along every axis and takes the cheapest surface area cost,
+ * falling back to a median split when binning cannot separate them. rays use moller-trumbore.
+ */
+
+namespace lve {
+
+void LveMeshBvh::build(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices) {
+  const uint32_t triangleCount = static_cast<uint32_t>((indices.empty() ? positions.size() : indices.size()) / 3);
+  auto vertex = [&](uint32_t triangle, uint32_t corner) -> const glm::vec3 & {
+    uint32_t i = triangle * 3 + corner;
+    return positions[indices.empty() ? i : indices[i]];
+  };
+
+  nodes.clear();
+  triangles.clear();
+  triangleIds.clear();
+  if (triangleCount == 0) return;
+
+  std::vector<LveAabb> bounds(triangleCount);
+  std::vector<glm::vec3> centers(triangleCount);
+  Node root{};
+  root.count = triangleCount;
+  for (uint32_t t = 0; t < triangleCount; t++) {
+    for (uint32_t corner = 0; corner < 3; corner++) {
+      bounds[t].min = glm::min(bounds[t].min, vertex(t, corner));
+      bounds[t].max = glm::max(bounds[t].max, vertex(t, corner));
+    }
+    centers[t] = bounds[t].center();
+    root.box = LveAabb::merged(root.box, bounds[t]);
+  }
+
+  // a binary tree over n leaves never needs more than 2n - 1 nodes, so the vector never reallocates
+  nodes.reserve(2 * triangleCount);
+  nodes.push_back(root);
+  std::vector<uint32_t> order(triangleCount);
+  std::iota(order.begin(), order.end(), 0);
+  subdivide(0, 0, order, bounds, centers);
+  nodes.shrink_to_fit();
+
+  triangles.resize(triangleCount);
+  triangleIds = std::move(order);
+  for (uint32_t i = 0; i < triangleCount; i++) {
+    uint32_t t = triangleIds[i];
+    triangles[i] = {vertex(t, 0), vertex(t, 1) - vertex(t, 0), vertex(t, 2) - vertex(t, 0)};
+  }
+}
+
+void LveMeshBvh::subdivide(uint32_t node, uint32_t depth, std::vector<uint32_t> &order, const std::vector<LveAabb> &bounds,
+    const std::vector<glm::vec3> &centers) {
+  const uint32_t first = nodes[node].first;
+  const uint32_t count = nodes[node].count;
+  if (count <= MAX_LEAF_TRIANGLES || depth >= MAX_DEPTH) return;
+
+  LveAabb centerBounds{};
+  for (uint32_t i = first; i < first + count; i++) {
+    centerBounds.min = glm::min(centerBounds.min, centers[order[i]]);
+    centerBounds.max = glm::max(centerBounds.max, centers[order[i]]);
+  }
+
+  int bestAxis = -1;
+  uint32_t bestSplit = 0;
+  float bestCost = std::numeric_limits<float>::max();
+  for (int axis = 0; axis < 3; axis++) {
+    float extent = centerBounds.max[axis] - centerBounds.min[axis];
+    if (extent <= 0.f) continue;
+    float scale = SAH_BINS / extent;
+
+    LveAabb binBoxes[SAH_BINS];
+    uint32_t binCounts[SAH_BINS] = {};
+    for (uint32_t i = first; i < first + count; i++) {
+      uint32_t t = order[i];
+      uint32_t bin = std::min(SAH_BINS - 1, static_cast<uint32_t>((centers[t][axis] - centerBounds.min[axis]) * scale));
+      binCounts[bin]++;
+      binBoxes[bin] = LveAabb::merged(binBoxes[bin], bounds[t]);
+    }
+
+    // sweep from the right to get the cost of everything above each split plane
+    float rightAreas[SAH_BINS];
+    uint32_t rightCounts[SAH_BINS];
+    LveAabb rightBox{};
+    uint32_t rightCount = 0;
+    for (uint32_t bin = SAH_BINS - 1; bin > 0; bin--) {
+      rightBox = LveAabb::merged(rightBox, binBoxes[bin]);
+      rightCount += binCounts[bin];
+      rightAreas[bin] = rightCount ? rightBox.surfaceArea() : 0.f;
+      rightCounts[bin] = rightCount;
+    }
+    LveAabb leftBox{};
+    uint32_t leftCount = 0;
+    for (uint32_t split = 1; split < SAH_BINS; split++) {
+      leftBox = LveAabb::merged(leftBox, binBoxes[split - 1]);
+      leftCount += binCounts[split - 1];
+      if (leftCount == 0 || rightCounts[split] == 0) continue;
+      float cost = leftCount * leftBox.surfaceArea() + rightCounts[split] * rightAreas[split];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = split;
+      }
+    }
+  }
+
+  auto begin = order.begin() + first;
+  auto end = begin + count;
+  uint32_t leftCount = 0;
+  if (bestAxis >= 0) {
+    // splitting has to beat testing every triangle here, unless the leaf would get large
+    float leafCost = count * nodes[node].box.surfaceArea();
+    if (bestCost >= leafCost && count <= 4 * MAX_LEAF_TRIANGLES) return;
+    float scale = SAH_BINS / (centerBounds.max[bestAxis] - centerBounds.min[bestAxis]);
+    auto middle = std::partition(begin, end, [&](uint32_t t) {
+      uint32_t bin = std::min(SAH_BINS - 1, static_cast<uint32_t>((centers[t][bestAxis] - centerBounds.min[bestAxis]) * scale));
+      return bin < bestSplit;
+    });
+    leftCount = static_cast<uint32_t>(middle - begin);
+  }
+  if (leftCount == 0 || leftCount == count) {
+    // coincident centres, split the run in half so the depth stays bounded
+    leftCount = count / 2;
+  }
+
+  uint32_t left = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  nodes.emplace_back();
+  nodes[left].first = first;
+  nodes[left].count = leftCount;
+  nodes[left + 1].first = first + leftCount;
+  nodes[left + 1].count = count - leftCount;
+  for (uint32_t child = left; child < left + 2; child++) {
+    for (uint32_t i = nodes[child].first; i < nodes[child].first + nodes[child].count; i++) {
+      nodes[child].box = LveAabb::merged(nodes[child].box, bounds[order[i]]);
+    }
+  }
+  nodes[node].first = left;
+  nodes[node].count = 0;
+
+  subdivide(left, depth + 1, order, bounds, centers);
+  subdivide(left + 1, depth + 1, order, bounds, centers);
+}
+
+LveMeshBvh::RayHit LveMeshBvh::raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance) const noexcept {
+  RayHit hit{};
+  hit.distance = maxDistance;
+  if (nodes.empty()) return hit;
+  const glm::vec3 invDir = 1.f / dir;
+
+  // nearest child first, so later subtrees are mostly rejected by the shrinking hit distance
+  // entry distances ride along so a subtree pushed before a closer hit was found can be skipped
+  uint32_t stack[2 * MAX_DEPTH + 2];
+  float stackEntry[2 * MAX_DEPTH + 2];
+  uint32_t stackSize = 0;
+  float rootEntry = nodes[0].box.intersectRay(origin, invDir, hit.distance);
+  if (rootEntry >= 0.f) {
+    stack[0] = 0;
+    stackEntry[0] = rootEntry;
+    stackSize = 1;
+  }
+  while (stackSize > 0) {
+    stackSize--;
+    if (stackEntry[stackSize] > hit.distance) continue;
+    const Node &node = nodes[stack[stackSize]];
+    if (node.count > 0) {
+      for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        const Triangle &tri = triangles[i];
+        glm::vec3 p = glm::cross(dir, tri.edge2);
+        float det = glm::dot(tri.edge1, p);
+        if (std::fabs(det) < 1e-12f) continue;
+        float invDet = 1.f / det;
+        glm::vec3 s = origin - tri.v0;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.f || u > 1.f) continue;
+        glm::vec3 q = glm::cross(s, tri.edge1);
+        float v = glm::dot(dir, q) * invDet;
+        if (v < 0.f || u + v > 1.f) continue;
+        float t = glm::dot(tri.edge2, q) * invDet;
+        if (t >= 0.f && t < hit.distance) {
+          hit.distance = t;
+          hit.triangle = triangleIds[i];
+        }
+      }
+      continue;
+    }
+
+    float tLeft = nodes[node.first].box.intersectRay(origin, invDir, hit.distance);
+    float tRight = nodes[node.first + 1].box.intersectRay(origin, invDir, hit.distance);
+    uint32_t nearChild = node.first, farChild = node.first + 1;
+    if (tRight >= 0.f && (tLeft < 0.f || tRight < tLeft)) {
+      std::swap(nearChild, farChild);
+      std::swap(tLeft, tRight);
+    }
+    if (tRight >= 0.f) {
+      stack[stackSize] = farChild;
+      stackEntry[stackSize++] = tRight;
+    }
+    if (tLeft >= 0.f) {
+      stack[stackSize] = nearChild;
+      stackEntry[stackSize++] = tLeft;
+    }
+  }
+  return hit;
+}
+
+}  // namespace lve
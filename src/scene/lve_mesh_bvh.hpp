@@ -0,0 +1,61 @@
+#pragma once
+
+#include "scene/lve_bvh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * static triangle bvh of one mesh, kept on the cpu for exact ray picking.
+ * built once at load with binned surface area splits; triangles are stored pre-transformed into
+ * vertex + edge form in leaf order, so a leaf test reads one contiguous run.
+ */
+
+namespace lve {
+
+class LveMeshBvh {
+ public:
+  static constexpr uint32_t MAX_LEAF_TRIANGLES = 4;
+  static constexpr uint32_t MAX_DEPTH = 64;
+  static constexpr uint32_t SAH_BINS = 16;
+
+  struct RayHit {
+    uint32_t triangle = std::numeric_limits<uint32_t>::max();  // index into the source index list / 3
+    float distance = std::numeric_limits<float>::max();
+    bool isHit() const noexcept { return triangle != std::numeric_limits<uint32_t>::max(); }
+  };
+
+  /** indexed triangle list, or consecutive vertex triples when indices is empty. */
+  void build(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices);
+
+  /** nearest triangle hit by origin + t * dir with t in [0, maxDistance], both faces count. */
+  RayHit raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance) const noexcept;
+
+  uint32_t getTriangleCount() const noexcept { return static_cast<uint32_t>(triangles.size()); }
+  uint32_t getNodeCount() const noexcept { return static_cast<uint32_t>(nodes.size()); }
+
+ private:
+  struct Node {
+    LveAabb box;
+    uint32_t first = 0;  // first triangle for leaves, left child for inner nodes (right is first + 1)
+    uint32_t count = 0;  // 0 for inner nodes
+  };
+
+  struct Triangle {
+    glm::vec3 v0;
+    glm::vec3 edge1;
+    glm::vec3 edge2;
+  };
+
+  void subdivide(uint32_t node, uint32_t depth, std::vector<uint32_t> &order, const std::vector<LveAabb> &bounds,
+      const std::vector<glm::vec3> &centers);
+
+  std::vector<Node> nodes;
+  std::vector<Triangle> triangles;
+  std::vector<uint32_t> triangleIds;
+};
+
+}  // namespace lve
@@ -35,14 +35,26 @@ struct hash<lve::LveModel::Vertex> {
 
 namespace lve {
 
-LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder) : lveDevice{device} {
-  createVertexBuffers(builder.vertices);
-  createIndexBuffers(builder.indices);
+LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder, LveGeometryPool *pool) : lveDevice{device}, geometryPool{pool} {
+  if (geometryPool) {
+    vertexCount = static_cast<uint32_t>(builder.vertices.size());
+    indexCount = static_cast<uint32_t>(builder.indices.size());
+    hasIndexBuffer = indexCount > 0;
+    assert(vertexCount >= 3 && "vertex count must be at least 3");
+    poolRange = geometryPool->allocate(builder.vertices.data(), vertexCount, builder.indices.data(), indexCount);
+  } else {
+    createVertexBuffers(builder.vertices);
+    createIndexBuffers(builder.indices);
+  }
 
+  std::vector<glm::vec3> positions;
+  positions.reserve(builder.vertices.size());
   for (const auto& v : builder.vertices) {
     boundingBox.min = glm::min(boundingBox.min, v.position);
     boundingBox.max = glm::max(boundingBox.max, v.position);
+    positions.push_back(v.position);
   }
+  triangleBvh.build(positions, builder.indices);
 
   constexpr float eps = 0.0001f;
   if (boundingBox.max.x - boundingBox.min.x < eps) { boundingBox.min.x -= eps * 0.5f; boundingBox.max.x += eps * 0.5f; }
@@ -50,12 +62,14 @@ LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder) : lveDev
   if (boundingBox.max.z - boundingBox.min.z < eps) { boundingBox.min.z -= eps * 0.5f; boundingBox.max.z += eps * 0.5f; }
 }
 
-LveModel::~LveModel() = default;
+LveModel::~LveModel() {
+  if (geometryPool) geometryPool->free(poolRange);
+}
 
-std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath) {
+std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath, LveGeometryPool *pool) {
   Builder builder;
   builder.loadModel(ENGINE_DIR + filepath);
-  return std::make_unique<LveModel>(device, builder);
+  return std::make_unique<LveModel>(device, builder, pool);
 }
 
 void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
@@ -64,12 +78,8 @@ void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
   VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
   uint32_t vertexSize = sizeof(vertices[0]);
 
-  LveBuffer staging{lveDevice, vertexSize, vertexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-  staging.map();
-  staging.writeToBuffer((void *)vertices.data());
-
-  vertexBuffer = std::make_unique<LveBuffer>(lveDevice, vertexSize, vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  lveDevice.copyBuffer(staging.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+  vertexBuffer = std::make_unique<LveBuffer>(lveDevice, vertexSize, vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, lveDevice.uploadMemoryProperties(), 1, LveMemoryTag::Mesh);
+  vertexBuffer->upload(lveDevice.streamingQueue(), vertices.data(), bufferSize, 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 }
 
 void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
@@ -80,24 +90,26 @@ void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
   VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
   uint32_t indexSize = sizeof(indices[0]);
 
-  LveBuffer staging{lveDevice, indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-  staging.map();
-  staging.writeToBuffer((void *)indices.data());
-
-  indexBuffer = std::make_unique<LveBuffer>(lveDevice, indexSize, indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-  lveDevice.copyBuffer(staging.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+  indexBuffer = std::make_unique<LveBuffer>(lveDevice, indexSize, indexCount, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, lveDevice.uploadMemoryProperties(), 1, LveMemoryTag::Mesh);
+  indexBuffer->upload(lveDevice.streamingQueue(), indices.data(), bufferSize, 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 }
 
-void LveModel::draw(VkCommandBuffer cmd) {
-  if (hasIndexBuffer) vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, 0);
-  else vkCmdDraw(cmd, vertexCount, 1, 0, 0);
+void LveModel::draw(LveCommandRecorder &recorder, uint32_t instanceCount, uint32_t firstInstance) {
+  uint32_t firstIndex = geometryPool ? poolRange.firstIndex : 0;
+  uint32_t vertexOffset = geometryPool ? poolRange.vertexOffset : 0;
+  if (hasIndexBuffer) recorder.drawIndexed(indexCount, instanceCount, firstIndex, static_cast<int32_t>(vertexOffset), firstInstance);
+  else recorder.draw(vertexCount, instanceCount, vertexOffset, firstInstance);
 }
 
-void LveModel::bind(VkCommandBuffer cmd) {
+void LveModel::bind(LveCommandRecorder &recorder) {
+  if (geometryPool) {
+    geometryPool->bind(recorder, poolRange.page);
+    return;
+  }
   VkBuffer buffers[] = {vertexBuffer->getBuffer()};
   VkDeviceSize offsets[] = {0};
-  vkCmdBindVertexBuffers(cmd, 0, 1, buffers, offsets);
-  if (hasIndexBuffer) vkCmdBindIndexBuffer(cmd, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+  recorder.bindVertexBuffers(0, 1, buffers, offsets);
+  if (hasIndexBuffer) recorder.bindIndexBuffer(indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
 }
 
 std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions() {
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "renderer/lve_buffer.hpp"
+#include "renderer/lve_geometry_pool.hpp"
 #include "core/lve_device.hpp"
+#include "scene/lve_mesh_bvh.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -45,18 +47,39 @@ class LveModel {
     glm::vec3 max{std::numeric_limits<float>::lowest()};
   };
 
-  LveModel(LveDevice &device, const LveModel::Builder &builder);
+  // with a pool the mesh is suballocated from its shared pages instead of owning buffers
+  LveModel(LveDevice &device, const LveModel::Builder &builder, LveGeometryPool *pool = nullptr);
   ~LveModel();
 
   LveModel(const LveModel &) = delete;
   LveModel &operator=(const LveModel &) = delete;
 
-  static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath);
+  static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath, LveGeometryPool *pool = nullptr);
 
-  void bind(VkCommandBuffer commandBuffer);
-  void draw(VkCommandBuffer commandBuffer);
+  void bind(LveCommandRecorder &recorder);
+  // instances read their per-instance data by gl_InstanceIndex, starting at firstInstance
+  void draw(LveCommandRecorder &recorder, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
 
   const BoundingBox& getBoundingBox() const noexcept { return boundingBox; }
+  // cpu side copy of the triangles for picking, in model space
+  const LveMeshBvh& getTriangleBvh() const noexcept { return triangleBvh; }
+  bool isPooled() const noexcept { return geometryPool != nullptr; }
+  bool hasIndices() const noexcept { return hasIndexBuffer; }
+  // the arguments draw() passes to vkCmdDrawIndexed, for building indirect commands
+  uint32_t getIndexCount() const noexcept { return indexCount; }
+  uint32_t getFirstIndex() const noexcept { return geometryPool ? poolRange.firstIndex : 0; }
+  int32_t getVertexOffset() const noexcept { return static_cast<int32_t>(geometryPool ? poolRange.vertexOffset : 0); }
+  const LveGeometryPool::Range& getPoolRange() const noexcept { return poolRange; }
+
+  // equal for models whose bind() binds the same buffers, for grouping draws by sort key
+  uint64_t getBindingId() const noexcept {
+    return geometryPool ? reinterpret_cast<uintptr_t>(geometryPool) + poolRange.page : reinterpret_cast<uintptr_t>(this);
+  }
+
+  // true when bind() would bind the exact same buffers, so a draw loop can skip it
+  bool sharesBuffersWith(const LveModel &other) const noexcept {
+    return geometryPool && geometryPool == other.geometryPool && poolRange.page == other.poolRange.page;
+  }
 
  private:
   void createVertexBuffers(const std::vector<Vertex> &vertices);
@@ -70,7 +93,11 @@ class LveModel {
   std::unique_ptr<LveBuffer> indexBuffer;
   uint32_t indexCount;
 
+  LveGeometryPool *geometryPool = nullptr;
+  LveGeometryPool::Range poolRange{};
+
   BoundingBox boundingBox;
+  LveMeshBvh triangleBvh;
 };
 
 }  // namespace lve
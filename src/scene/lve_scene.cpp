@@ -0,0 +1,248 @@
+#include "scene/lve_scene.hpp"
+
+#include "core/lve_thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * scene implementation.
+ * freed slots are recycled in lifo order, their generation is bumped so old handles go stale.
+ * the depth first transform order is rebuilt lazily on the next update after the hierarchy changes.
+ */
+
+namespace lve {
+
+LveEntity LveScene::createEntity(const std::string &name) {
+  uint32_t index;
+  if (!freeIndices.empty()) {
+    index = freeIndices.back();
+    freeIndices.pop_back();
+  } else {
+    index = static_cast<uint32_t>(generations.size());
+    generations.push_back(0);
+    parents.push_back(NONE);
+    proxies.push_back(NONE);
+  }
+  entityCount++;
+
+  LveEntity entity{index, generations[index]};
+  add<TransformComponent>(entity);
+  if (!name.empty()) add<NameComponent>(entity, {name});
+
+  // a new root appended after the last subtree keeps the order valid
+  if (!hierarchyDirty) {
+    uint32_t slot = static_cast<uint32_t>(parentSlots.size());
+    parentSlots.push_back(NONE);
+    subtreeEnds.push_back(slot + 1);
+    worldChanged.push_back(0);
+    rootRanges.push_back({slot, slot + 1});
+  }
+  return entity;
+}
+
+LveEntity LveScene::createPointLight(float intensity, float radius, glm::vec3 color, const std::string &name) {
+  LveEntity light = createEntity(name);
+  get<TransformComponent>(light).setScale({radius, 1.f, 1.f});
+  add<PointLightComponent>(light, {color, intensity});
+  return light;
+}
+
+void LveScene::destroyEntity(LveEntity entity) {
+  if (!isAlive(entity)) return;
+  if (hierarchyDirty) rebuildHierarchy();
+
+  // the subtree is the contiguous slot run starting at the entity
+  const auto &transforms = pool<TransformComponent>();
+  uint32_t root = transforms.slotOf(entity.index);
+  std::vector<uint32_t> doomed;
+  for (uint32_t slot = root; slot < subtreeEnds[root]; slot++) doomed.push_back(transforms.ownerAt(slot));
+
+  for (uint32_t index : doomed) {
+    releaseProxy(index);
+    std::apply([&](auto &...pool) { (pool.erase(index), ...); }, pools);
+    parents[index] = NONE;
+    generations[index]++;
+    freeIndices.push_back(index);
+    entityCount--;
+  }
+  hierarchyDirty = true;
+}
+
+void LveScene::setParent(LveEntity child, LveEntity parent) {
+  if (!isAlive(child)) return;
+  uint32_t parentIndex = isAlive(parent) ? parent.index : NONE;
+  for (uint32_t ancestor = parentIndex; ancestor != NONE; ancestor = parents[ancestor]) {
+    if (ancestor == child.index) throw std::runtime_error("cannot parent an entity to itself or its descendant");
+  }
+  if (parents[child.index] == parentIndex) return;
+
+  parents[child.index] = parentIndex;
+  get<TransformComponent>(child).markDirty();
+  hierarchyDirty = true;
+}
+
+LveEntity LveScene::getParent(LveEntity entity) const noexcept {
+  if (!isAlive(entity) || parents[entity.index] == NONE) return {};
+  return handleOf(parents[entity.index]);
+}
+
+void LveScene::rebuildHierarchy() {
+  auto &transforms = pool<TransformComponent>();
+  const uint32_t count = transforms.size();
+
+  // children grouped per parent with a counting sort, in current slot order so siblings keep theirs
+  std::vector<uint32_t> childStart(generations.size() + 1, 0);
+  for (uint32_t slot = 0; slot < count; slot++) {
+    uint32_t parent = parents[transforms.ownerAt(slot)];
+    if (parent != NONE) childStart[parent + 1]++;
+  }
+  for (size_t i = 1; i < childStart.size(); i++) childStart[i] += childStart[i - 1];
+  std::vector<uint32_t> children(childStart.back());
+  std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+  for (uint32_t slot = 0; slot < count; slot++) {
+    uint32_t index = transforms.ownerAt(slot);
+    if (parents[index] != NONE) children[fill[parents[index]]++] = index;
+  }
+
+  // preorder walk from every root
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> slotOf(generations.size(), NONE);
+  std::vector<uint32_t> stack;
+  order.reserve(count);
+  parentSlots.assign(count, NONE);
+  rootRanges.clear();
+  for (uint32_t slot = 0; slot < count; slot++) {
+    uint32_t root = transforms.ownerAt(slot);
+    if (parents[root] != NONE) continue;
+    uint32_t begin = static_cast<uint32_t>(order.size());
+    stack.push_back(root);
+    while (!stack.empty()) {
+      uint32_t index = stack.back();
+      stack.pop_back();
+      uint32_t position = static_cast<uint32_t>(order.size());
+      slotOf[index] = position;
+      if (parents[index] != NONE) parentSlots[position] = slotOf[parents[index]];
+      order.push_back(index);
+      for (uint32_t c = childStart[index + 1]; c > childStart[index]; c--) stack.push_back(children[c - 1]);
+    }
+    rootRanges.push_back({begin, static_cast<uint32_t>(order.size())});
+  }
+  assert(order.size() == count && "every transform must be reachable from a root");
+
+  subtreeEnds.resize(count);
+  for (uint32_t slot = 0; slot < count; slot++) subtreeEnds[slot] = slot + 1;
+  for (uint32_t slot = count; slot-- > 0;) {
+    if (parentSlots[slot] != NONE) subtreeEnds[parentSlots[slot]] = std::max(subtreeEnds[parentSlots[slot]], subtreeEnds[slot]);
+  }
+
+  transforms.reorder(order);
+  worldChanged.assign(count, 0);
+  hierarchyDirty = false;
+}
+
+uint32_t LveScene::propagateTransforms(SlotRange range) {
+  auto &transforms = pool<TransformComponent>();
+  uint32_t updated = 0;
+  for (uint32_t slot = range.begin; slot < range.end; slot++) {
+    auto &transform = transforms.at(slot);
+    uint32_t parent = parentSlots[slot];
+    bool changed = transform.updateLocal() || (parent != NONE && worldChanged[parent]);
+    worldChanged[slot] = changed;
+    if (!changed) continue;
+
+    if (parent == NONE) {
+      transform.worldMatrix = transform.localMatrix;
+      transform.worldNormal = transform.localNormal;
+    } else {
+      const auto &parentTransform = transforms.at(parent);
+      transform.worldMatrix = parentTransform.worldMatrix * transform.localMatrix;
+      transform.worldNormal = parentTransform.worldNormal * transform.localNormal;
+    }
+    transform.worldVersion++;
+    updated++;
+  }
+  return updated;
+}
+
+uint32_t LveScene::updateTransforms(LveThreadPool *workers) {
+  if (hierarchyDirty) rebuildHierarchy();
+  const uint32_t count = pool<TransformComponent>().size();
+  if (!workers || count < 2 * MIN_TRANSFORMS_PER_TASK) return propagateTransforms({0, count});
+
+  // whole root subtrees per task, so no task ever reads a parent another one is writing
+  const uint32_t target = std::max(MIN_TRANSFORMS_PER_TASK, count / (4 * (workers->getThreadCount() + 1)));
+  updateTasks.clear();
+  for (const auto &root : rootRanges) {
+    if (updateTasks.empty() || updateTasks.back().end - updateTasks.back().begin >= target) {
+      updateTasks.push_back(root);
+    } else {
+      updateTasks.back().end = root.end;
+    }
+  }
+
+  std::vector<uint32_t> updated(updateTasks.size(), 0);
+  workers->run(static_cast<uint32_t>(updateTasks.size()), [&](uint32_t task, uint32_t) { updated[task] = propagateTransforms(updateTasks[task]); });
+  uint32_t total = 0;
+  for (uint32_t n : updated) total += n;
+  return total;
+}
+
+uint32_t LveScene::updateBounds() {
+  if (hierarchyDirty) updateTransforms();
+  const auto &meshes = pool<MeshComponent>();
+  const auto &transforms = pool<TransformComponent>();
+  uint32_t reinserted = 0;
+  for (uint32_t slot = 0; slot < meshes.size(); slot++) {
+    uint32_t index = meshes.ownerAt(slot);
+    uint32_t transformSlot = transforms.slotOf(index);
+    bool isNew = proxies[index] == NONE;
+    if (!isNew && !worldChanged[transformSlot]) continue;
+
+    const auto &local = meshes.at(slot).model->getBoundingBox();
+    LveAabb box = LveAabb::transformed(transforms.at(transformSlot).mat4(), local.min, local.max);
+    if (isNew) {
+      proxies[index] = bvh.insert(box, index);
+    } else if (bvh.update(proxies[index], box)) {
+      reinserted++;
+    }
+  }
+  if (bvh.isDegraded()) bvh.rebuild();
+  return reinserted;
+}
+
+LveSceneHit LveScene::raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance) const {
+  const auto &meshes = pool<MeshComponent>();
+  const auto &transforms = pool<TransformComponent>();
+  uint32_t triangle = 0;
+  auto hit = bvh.raycast(origin, dir, maxDistance, [&](uint32_t index, float closest) {
+    // an affine inverse keeps t unchanged, so model space distances compare directly
+    const glm::mat4 toModel = glm::inverse(transforms.find(index)->mat4());
+    const glm::vec3 localOrigin{toModel * glm::vec4(origin, 1.f)};
+    const glm::vec3 localDir{toModel * glm::vec4(dir, 0.f)};
+    auto meshHit = meshes.find(index)->model->getTriangleBvh().raycast(localOrigin, localDir, closest);
+    if (!meshHit.isHit()) return -1.f;
+    triangle = meshHit.triangle;
+    return meshHit.distance;
+  });
+
+  LveSceneHit result{};
+  if (hit.isHit()) result = {handleOf(hit.userData), triangle, hit.distance};
+  return result;
+}
+
+void LveScene::releaseProxy(uint32_t index) {
+  if (proxies[index] == NONE) return;
+  bvh.remove(proxies[index]);
+  proxies[index] = NONE;
+}
+
+LveEntity LveScene::findByName(const std::string &name) const {
+  const auto &names = pool<NameComponent>();
+  for (uint32_t slot = 0; slot < names.size(); slot++) {
+    if (names.at(slot).name == name) return handleOf(names.ownerAt(slot));
+  }
+  return {};
+}
+
+}  // namespace lve
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "scene/lve_bvh.hpp"
+#include "scene/lve_components.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * data oriented entity store.
+ * entities are generational handles into a slot table; each component type lives in its own
+ * densely packed pool so systems walk contiguous arrays instead of chasing map nodes.
+ * entities form a hierarchy through their transforms, whose pool is kept in depth first order.
+ * mesh entities are mirrored into a dynamic bvh of world boxes for culling, picking and overlap queries.
+ */
+
+namespace lve {
+
+class LveThreadPool;
+
+/** stable handle to an entity. stays invalid once the entity is destroyed, even if its slot is reused. */
+struct LveEntity {
+  static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+  uint32_t index = INVALID_INDEX;
+  uint32_t generation = 0;
+
+  bool isValid() const noexcept { return index != INVALID_INDEX; }
+  bool operator==(const LveEntity &other) const noexcept = default;
+};
+
+/** nearest mesh surface under a ray, triangle indexes the model's index list / 3. */
+struct LveSceneHit {
+  LveEntity entity{};
+  uint32_t triangle = 0;
+  float distance = 0.f;
+  bool isHit() const noexcept { return entity.isValid(); }
+};
+
+/**
+ * sparse set of one component type.
+ * components and their owning slot indices are packed in parallel arrays, removal swaps the last
+ * element into the hole so the arrays never fragment.
+ */
+template <typename T>
+class LveComponentPool {
+ public:
+  static constexpr uint32_t NPOS = std::numeric_limits<uint32_t>::max();
+
+  T &insert(uint32_t index, T value) {
+    if (index >= sparse.size()) sparse.resize(index + 1, NPOS);
+    if (sparse[index] != NPOS) return components[sparse[index]] = std::move(value);
+    sparse[index] = static_cast<uint32_t>(components.size());
+    owners.push_back(index);
+    return components.emplace_back(std::move(value));
+  }
+
+  void erase(uint32_t index) {
+    if (!contains(index)) return;
+    uint32_t slot = sparse[index];
+    uint32_t last = static_cast<uint32_t>(components.size() - 1);
+    if (slot != last) {
+      components[slot] = std::move(components[last]);
+      owners[slot] = owners[last];
+      sparse[owners[slot]] = slot;
+    }
+    components.pop_back();
+    owners.pop_back();
+    sparse[index] = NPOS;
+  }
+
+  bool contains(uint32_t index) const noexcept { return index < sparse.size() && sparse[index] != NPOS; }
+  uint32_t slotOf(uint32_t index) const noexcept { return contains(index) ? sparse[index] : NPOS; }
+  T *find(uint32_t index) noexcept { return contains(index) ? &components[sparse[index]] : nullptr; }
+  const T *find(uint32_t index) const noexcept { return contains(index) ? &components[sparse[index]] : nullptr; }
+
+  uint32_t size() const noexcept { return static_cast<uint32_t>(components.size()); }
+  T &at(uint32_t slot) noexcept { return components[slot]; }
+  const T &at(uint32_t slot) const noexcept { return components[slot]; }
+  uint32_t ownerAt(uint32_t slot) const noexcept { return owners[slot]; }
+
+  T *data() noexcept { return components.data(); }
+  const T *data() const noexcept { return components.data(); }
+
+  /** permutes the packed arrays so owners come out in the given order, which must hold each owner once. */
+  void reorder(const std::vector<uint32_t> &order) {
+    assert(order.size() == components.size() && "reorder needs every owner exactly once");
+    std::vector<T> sorted;
+    sorted.reserve(order.size());
+    for (uint32_t index : order) sorted.push_back(std::move(components[sparse[index]]));
+    for (uint32_t slot = 0; slot < order.size(); slot++) sparse[order[slot]] = slot;
+    components = std::move(sorted);
+    owners = order;
+  }
+
+ private:
+  std::vector<uint32_t> sparse;
+  std::vector<uint32_t> owners;
+  std::vector<T> components;
+};
+
+class LveScene {
+ public:
+  LveScene() = default;
+
+  LveScene(const LveScene &) = delete;
+  LveScene &operator=(const LveScene &) = delete;
+
+  /** every entity is created with a transform, the one component all passes rely on. */
+  LveEntity createEntity(const std::string &name = {});
+  LveEntity createPointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f), const std::string &name = {});
+
+  /** removes the entity, its descendants and all of their components. stale handles are ignored. */
+  void destroyEntity(LveEntity entity);
+
+  /**
+   * attaches child under parent, or makes it a root again when parent is invalid. the child keeps
+   * its local transform, which from then on is relative to the parent.
+   */
+  void setParent(LveEntity child, LveEntity parent);
+  LveEntity getParent(LveEntity entity) const noexcept;
+
+  bool isAlive(LveEntity entity) const noexcept {
+    return entity.index < generations.size() && generations[entity.index] == entity.generation;
+  }
+
+  /**
+   * rebuilds the world matrices of every transform changed since the last call and of everything
+   * below it, returning how many. run once per frame after gameplay and before any pass reads mat4().
+   * independent root subtrees are split across workers when given and the scene is large enough.
+   */
+  uint32_t updateTransforms(LveThreadPool *workers = nullptr);
+
+  /**
+   * moves the bvh leaves of meshes whose world matrix changed in the last updateTransforms() and
+   * adds leaves for new meshes, returning how many leaves were reinserted. rebuilds the tree once
+   * incremental updates or bulk inserts have degraded it.
+   */
+  uint32_t updateBounds();
+
+  /** broadphase over mesh world boxes, leaf user data is the entity index, see handleOf(). */
+  const LveDynamicBvh &getBvh() const noexcept { return bvh; }
+
+  /**
+   * exact nearest mesh hit along origin + t * dir, t in [0, maxDistance]. the bvh picks candidate
+   * meshes front to back and each candidate's triangle bvh is queried in model space.
+   */
+  LveSceneHit raycast(const glm::vec3 &origin, const glm::vec3 &dir, float maxDistance) const;
+
+  /** looks an entity up by name, for tooling and persistence rather than per frame use. */
+  LveEntity findByName(const std::string &name) const;
+
+  template <typename T>
+  T &add(LveEntity entity, T component = {}) {
+    assert(isAlive(entity) && "cannot add a component to a dead entity");
+    return pool<T>().insert(entity.index, std::move(component));
+  }
+
+  template <typename T>
+  void remove(LveEntity entity) {
+    if (!isAlive(entity)) return;
+    if constexpr (std::is_same_v<T, MeshComponent>) releaseProxy(entity.index);
+    pool<T>().erase(entity.index);
+  }
+
+  template <typename T>
+  bool has(LveEntity entity) const noexcept {
+    return isAlive(entity) && pool<T>().contains(entity.index);
+  }
+
+  template <typename T>
+  T *tryGet(LveEntity entity) noexcept {
+    return isAlive(entity) ? pool<T>().find(entity.index) : nullptr;
+  }
+
+  template <typename T>
+  const T *tryGet(LveEntity entity) const noexcept {
+    return isAlive(entity) ? pool<T>().find(entity.index) : nullptr;
+  }
+
+  template <typename T>
+  T &get(LveEntity entity) noexcept {
+    assert(has<T>(entity) && "entity does not have the requested component");
+    return *pool<T>().find(entity.index);
+  }
+
+  template <typename T>
+  const T &get(LveEntity entity) const noexcept {
+    assert(has<T>(entity) && "entity does not have the requested component");
+    return *pool<T>().find(entity.index);
+  }
+
+  template <typename T>
+  LveComponentPool<T> &pool() noexcept {
+    return std::get<LveComponentPool<T>>(pools);
+  }
+
+  template <typename T>
+  const LveComponentPool<T> &pool() const noexcept {
+    return std::get<LveComponentPool<T>>(pools);
+  }
+
+  /**
+   * calls fn(entity, first, rest...) for every entity owning all listed components.
+   * walks the first type's pool in packed order, so list the rarest component first.
+   */
+  template <typename First, typename... Rest, typename Fn>
+  void each(Fn &&fn) {
+    auto &driver = pool<First>();
+    for (uint32_t slot = 0; slot < driver.size(); slot++) {
+      uint32_t index = driver.ownerAt(slot);
+      if (!(pool<Rest>().contains(index) && ...)) continue;
+      fn(handleOf(index), driver.at(slot), *pool<Rest>().find(index)...);
+    }
+  }
+
+  template <typename First, typename... Rest, typename Fn>
+  void each(Fn &&fn) const {
+    const auto &driver = pool<First>();
+    for (uint32_t slot = 0; slot < driver.size(); slot++) {
+      uint32_t index = driver.ownerAt(slot);
+      if (!(pool<Rest>().contains(index) && ...)) continue;
+      fn(handleOf(index), driver.at(slot), *pool<Rest>().find(index)...);
+    }
+  }
+
+  LveEntity handleOf(uint32_t index) const noexcept { return {index, generations[index]}; }
+  uint32_t getEntityCount() const noexcept { return entityCount; }
+
+ private:
+  static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+  // transforms per update task below which a worker costs more than it saves
+  static constexpr uint32_t MIN_TRANSFORMS_PER_TASK = 4096;
+
+  // [begin, end) in transform slot order
+  struct SlotRange {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  void rebuildHierarchy();
+  uint32_t propagateTransforms(SlotRange range);
+  void releaseProxy(uint32_t index);
+
+  std::tuple<
+      LveComponentPool<TransformComponent>,
+      LveComponentPool<MeshComponent>,
+      LveComponentPool<MaterialComponent>,
+      LveComponentPool<PointLightComponent>,
+      LveComponentPool<NameComponent>>
+      pools;
+
+  // bumped on destroy, so handles to a freed slot never match again
+  std::vector<uint32_t> generations;
+  std::vector<uint32_t> freeIndices;
+  uint32_t entityCount = 0;
+
+  // by entity index
+  std::vector<uint32_t> parents;
+
+  // by transform slot. a parent always sits before its children and every subtree is contiguous,
+  // so one forward walk sees each parent's world matrix before its children need it
+  std::vector<uint32_t> parentSlots;
+  std::vector<uint32_t> subtreeEnds;
+  std::vector<uint8_t> worldChanged;
+  std::vector<SlotRange> rootRanges;
+  std::vector<SlotRange> updateTasks;
+  bool hierarchyDirty = false;
+
+  // bvh leaf of each mesh entity, by entity index
+  LveDynamicBvh bvh;
+  std::vector<uint32_t> proxies;
+};
+
+}  // namespace lve
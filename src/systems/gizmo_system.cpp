@@ -183,24 +183,16 @@ void GizmoSystem::createGizmoGeometry() {
   // Create vertex buffer and upload geometry
   VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
   
-  LveBuffer stagingBuffer{
-      lveDevice,
-      sizeof(vertices[0]),
-      vertexCount,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-  
-  stagingBuffer.map();
-  stagingBuffer.writeToBuffer(vertices.data());
-  
   vertexBuffer = std::make_unique<LveBuffer>(
       lveDevice,
       sizeof(vertices[0]),
       vertexCount,
       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      lveDevice.uploadMemoryProperties(),
+      1,
+      LveMemoryTag::Mesh);
   
-  lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+  vertexBuffer->upload(lveDevice.streamingQueue(), vertices.data(), bufferSize, 0, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 }
 
 /**
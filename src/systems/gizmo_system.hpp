@@ -10,7 +10,7 @@
 #include "core/lve_device.hpp"
 #include "renderer/lve_frame_info.hpp"
 #include "renderer/lve_pipeline.hpp"
-#include "scene/lve_game_object.hpp"
+#include "scene/lve_components.hpp"
 
 // std
 #include <memory>
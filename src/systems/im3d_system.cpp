@@ -15,8 +15,6 @@ namespace lve {
 Im3dSystem::Im3dSystem(LveDevice &device, VkRenderPass rp, VkDescriptorSetLayout layout) : lveDevice{device} {
   createPipelineLayout(layout);
   createPipelines(rp);
-  dynamicVertexBuffer = std::make_unique<LveBuffer>(lveDevice, sizeof(Im3dVertex), 131072, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-  dynamicVertexBuffer->map();
 }
 
 Im3dSystem::~Im3dSystem() {
@@ -52,12 +50,20 @@ void Im3dSystem::createPipelines(VkRenderPass rp) {
   trianglesPipeline = std::make_unique<LvePipeline>(lveDevice, "shaders/im3d.vert.spv", "shaders/im3d.frag.spv", config);
 }
 
+void Im3dSystem::createFrameResources(LveFrameContext &frame) {
+  frame.im3dVertexBuffer = std::make_unique<LveBuffer>(
+      lveDevice, sizeof(Im3dVertex), MAX_VERTICES, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, lveDevice.dynamicMemoryProperties(), 1, LveMemoryTag::Ui);
+  frame.im3dVertexBuffer->map();
+}
+
 void Im3dSystem::render(FrameInfo &frameInfo) {
   uint32_t count = Im3d::GetDrawListCount();
   if (count == 0) return;
 
   const auto* drawLists = Im3d::GetDrawLists();
+  auto& vertexBuffer = *frameInfo.frameContext.im3dVertexBuffer;
   uint32_t vPos = 0;
+  LveCommandRecorder recorder{frameInfo.commandBuffer, frameInfo.renderer.renderStats()};
 
   for (uint32_t i = 0; i < count; ++i) {
     const auto& dl = drawLists[i];
@@ -69,17 +75,17 @@ void Im3dSystem::render(FrameInfo &frameInfo) {
       default: continue;
     }
 
-    pipeline->bind(frameInfo.commandBuffer);
-    vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+    recorder.bindPipeline(*pipeline);
+    recorder.bindDescriptorSets(pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet);
 
     uint32_t vCount = dl.m_vertexCount;
-    if (vCount == 0 || vPos + vCount > 131072) continue;
+    if (vCount == 0 || vPos + vCount > MAX_VERTICES) continue;
 
     VkDeviceSize off = vPos * sizeof(Im3dVertex);
-    dynamicVertexBuffer->writeToBuffer((void*)dl.m_vertexData, sizeof(Im3dVertex) * vCount, off);
-    VkBuffer bufs[] = {dynamicVertexBuffer->getBuffer()};
-    vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1, bufs, &off);
-    vkCmdDraw(frameInfo.commandBuffer, vCount, 1, 0, 0);
+    vertexBuffer.writeToBuffer((void*)dl.m_vertexData, sizeof(Im3dVertex) * vCount, off);
+    VkBuffer bufs[] = {vertexBuffer.getBuffer()};
+    recorder.bindVertexBuffers(0, 1, bufs, &off);
+    recorder.draw(vCount, 1, 0, 0);
     vPos += vCount;
   }
 }
@@ -3,7 +3,7 @@
 #include "core/lve_device.hpp"
 #include "renderer/lve_frame_info.hpp"
 #include "renderer/lve_pipeline.hpp"
-#include "scene/lve_game_object.hpp"
+#include "scene/lve_components.hpp"
 
 #include <im3d.h>
 
@@ -26,6 +26,8 @@ class Im3dSystem {
   Im3dSystem(const Im3dSystem &) = delete;
   Im3dSystem &operator=(const Im3dSystem &) = delete;
 
+  // the vertex buffer is rewritten every frame, so each frame context gets its own
+  void createFrameResources(LveFrameContext &frame);
   void render(FrameInfo &frameInfo);
   static Im3d::Mat4 toIm3d(const glm::mat4& m) noexcept;
 
@@ -33,14 +35,14 @@ class Im3dSystem {
   void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
   void createPipelines(VkRenderPass renderPass);
 
+  static constexpr uint32_t MAX_VERTICES = 131072;
+
   LveDevice &lveDevice;
   
   VkPipelineLayout pipelineLayout;
   std::unique_ptr<LvePipeline> pointsPipeline;
   std::unique_ptr<LvePipeline> linesPipeline;
   std::unique_ptr<LvePipeline> trianglesPipeline;
-
-  std::unique_ptr<LveBuffer> dynamicVertexBuffer;
   
   struct Im3dVertex {
     glm::vec4 positionSize;
@@ -5,9 +5,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
-#include <map>
 #include <stdexcept>
 
 /**
@@ -61,56 +61,66 @@ void PointLightSystem::createPipeline(VkRenderPass rp) {
   lvePipeline = std::make_unique<LvePipeline>(lveDevice, "shaders/point_light.vert.spv", "shaders/point_light.frag.spv", config);
 }
 
-void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
+void PointLightSystem::animate(FrameInfo& frameInfo) {
   auto rot = glm::rotate(glm::mat4(1.f), 0.5f * frameInfo.frameTime, {0.f, -1.f, 0.f});
-  int idx = 0;
-  std::vector<LveGameObject*> regular;
-  LveGameObject* sun = nullptr;
-
-  for (auto& kv : frameInfo.gameObjects) {
-    auto& obj = kv.second;
-    if (!obj.pointLight) continue;
-    if (obj.pointLight->lightIntensity > 5000.f) sun = &obj;
-    else regular.push_back(&obj);
-  }
+  // the orbit turns the local translation, the sun stays put
+  frameInfo.scene.each<PointLightComponent, TransformComponent>([&](LveEntity, const PointLightComponent& light, TransformComponent& transform) {
+    if (light.lightIntensity > 5000.f) return;
+    transform.setTranslation(glm::vec3(rot * glm::vec4(transform.getTranslation(), 1.f)));
+  });
+}
 
-  for (auto l : regular) {
-    if (idx >= MAX_LIGHTS - 1) break;
-    l->transform.translation = glm::vec3(rot * glm::vec4(l->transform.translation, 1.f));
-    ubo.pointLights[idx].position = glm::vec4(l->transform.translation, 1.f);
-    ubo.pointLights[idx].color = glm::vec4(l->color, l->pointLight->lightIntensity);
+void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
+  int idx = 0;
+  const PointLightComponent* sun = nullptr;
+  const TransformComponent* sunTransform = nullptr;
+
+  // the sun always takes the last slot, the rest fill up in pool order
+  frameInfo.scene.each<PointLightComponent, TransformComponent>([&](LveEntity, const PointLightComponent& light, const TransformComponent& transform) {
+    if (light.lightIntensity > 5000.f) {
+      sun = &light;
+      sunTransform = &transform;
+      return;
+    }
+    if (idx >= MAX_LIGHTS - 1) return;
+    ubo.pointLights[idx].position = glm::vec4(glm::vec3(transform.mat4()[3]), 1.f);
+    ubo.pointLights[idx].color = glm::vec4(light.color, light.lightIntensity);
     idx++;
-  }
+  });
 
   if (sun) {
-    ubo.pointLights[idx].position = glm::vec4(sun->transform.translation, 1.f);
-    ubo.pointLights[idx].color = glm::vec4(sun->color, sun->pointLight->lightIntensity);
+    ubo.pointLights[idx].position = glm::vec4(glm::vec3(sunTransform->mat4()[3]), 1.f);
+    ubo.pointLights[idx].color = glm::vec4(sun->color, sun->lightIntensity);
     idx++;
   }
   ubo.numLights = idx;
 }
 
 void PointLightSystem::render(FrameInfo& frameInfo) {
-  std::map<float, LveGameObject::id_t> sorted;
-  for (auto& kv : frameInfo.gameObjects) {
-    auto& obj = kv.second;
-    if (!obj.pointLight) continue;
-    auto off = frameInfo.camera.getPosition() - obj.transform.translation;
-    sorted[glm::dot(off, off)] = obj.getId();
+  const auto& lights = frameInfo.scene.pool<PointLightComponent>();
+  const auto& transforms = frameInfo.scene.pool<TransformComponent>();
+  sortedLights.clear();
+  for (uint32_t slot = 0; slot < lights.size(); slot++) {
+    auto off = frameInfo.camera.getPosition() - glm::vec3(transforms.find(lights.ownerAt(slot))->mat4()[3]);
+    sortedLights.emplace_back(glm::dot(off, off), slot);
   }
+  // back to front for blending
+  std::sort(sortedLights.begin(), sortedLights.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
 
-  lvePipeline->bind(frameInfo.commandBuffer);
-  vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+  LveCommandRecorder recorder{frameInfo.commandBuffer, frameInfo.renderer.renderStats()};
+  recorder.bindPipeline(*lvePipeline);
+  recorder.bindDescriptorSets(pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet);
 
-  for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
-    auto& obj = frameInfo.gameObjects.at(it->second);
+  for (const auto& [distance, slot] : sortedLights) {
+    const auto& light = lights.at(slot);
+    const auto& transform = *transforms.find(lights.ownerAt(slot));
     PointLightPushConstants push{};
-    push.position = glm::vec4(obj.transform.translation, 1.f);
-    push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-    push.radius = obj.transform.scale.x;
+    push.position = glm::vec4(glm::vec3(transform.mat4()[3]), 1.f);
+    push.color = glm::vec4(light.color, light.lightIntensity);
+    push.radius = transform.getScale().x;
     
-    vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PointLightPushConstants), &push);
-    vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+    recorder.pushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PointLightPushConstants), &push);
+    recorder.draw(6, 1, 0, 0);
   }
 }
 
@@ -3,9 +3,9 @@
 #include "core/lve_device.hpp"
 #include "renderer/lve_frame_info.hpp"
 #include "renderer/lve_pipeline.hpp"
-#include "scene/lve_game_object.hpp"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 /**
@@ -23,6 +23,9 @@ class PointLightSystem {
   PointLightSystem(const PointLightSystem &) = delete;
   PointLightSystem &operator=(const PointLightSystem &) = delete;
 
+  /** moves the lights, before the scene's transform update. */
+  void animate(FrameInfo &frameInfo);
+  /** fills the ubo's lights from their world positions, after the transform update. */
   void update(FrameInfo &frameInfo, GlobalUbo &ubo);
   void render(FrameInfo &frameInfo);
 
@@ -33,6 +36,9 @@ class PointLightSystem {
   LveDevice &lveDevice;
   std::unique_ptr<LvePipeline> lvePipeline;
   VkPipelineLayout pipelineLayout;
+
+  // (distance squared, light pool slot), rebuilt every frame
+  std::vector<std::pair<float, uint32_t>> sortedLights;
 };
 
 }  // namespace lve
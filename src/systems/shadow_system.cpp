@@ -1,5 +1,7 @@
 #include "systems/shadow_system.hpp"
 
+#include "renderer/lve_instance_data.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -14,13 +16,13 @@
 
 namespace lve {
 
+// model matrices travel per instance through the frame allocator's storage binding
 struct ShadowPushConstantData {
-  glm::mat4 modelMatrix{1.f};
   glm::mat4 lightProjectionView{1.f};
 };
 
-ShadowSystem::ShadowSystem(LveDevice& device, VkRenderPass rp) : lveDevice{device} {
-  createPipelineLayout();
+ShadowSystem::ShadowSystem(LveDevice& device, VkRenderPass rp, VkDescriptorSetLayout objectLayout) : lveDevice{device} {
+  createPipelineLayout(objectLayout);
   createPipeline(rp);
 }
 
@@ -28,7 +30,7 @@ ShadowSystem::~ShadowSystem() {
   vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 }
 
-void ShadowSystem::createPipelineLayout() {
+void ShadowSystem::createPipelineLayout(VkDescriptorSetLayout objectLayout) {
   VkPushConstantRange range{};
   range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
   range.offset = 0;
@@ -36,8 +38,8 @@ void ShadowSystem::createPipelineLayout() {
   
   VkPipelineLayoutCreateInfo info{};
   info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-  info.setLayoutCount = 0;
-  info.pSetLayouts = nullptr;
+  info.setLayoutCount = 1;
+  info.pSetLayouts = &objectLayout;
   info.pushConstantRangeCount = 1;
   info.pPushConstantRanges = &range;
   
@@ -57,19 +59,71 @@ void ShadowSystem::createPipeline(VkRenderPass rp) {
   lvePipeline = std::make_unique<LvePipeline>(lveDevice, "shaders/shadow.vert.spv", "shaders/shadow.frag.spv", config);
 }
 
-void ShadowSystem::renderShadowMap(FrameInfo& frameInfo, const glm::mat4& lightProjView) {
-  lvePipeline->bind(frameInfo.commandBuffer);
-  for (auto& kv : frameInfo.gameObjects) {
-    auto& obj = kv.second;
-    if (!obj.model) continue;
-    ShadowPushConstantData push{};
-    push.modelMatrix = obj.transform.mat4();
-    push.lightProjectionView = lightProjView;
-    
-    vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowPushConstantData), &push);
-    obj.model->bind(frameInfo.commandBuffer);
-    obj.model->draw(frameInfo.commandBuffer);
+void ShadowSystem::renderShadowMap(FrameInfo& frameInfo, const glm::mat4& lightProjView, const std::vector<uint32_t>& casters) {
+  // depth only, so the mesh is the only state that changes between casters and each run of one model is one instanced draw
+  const auto& meshes = frameInfo.scene.pool<MeshComponent>();
+  const auto& transforms = frameInfo.scene.pool<TransformComponent>();
+
+  drawList.clear();
+  drawList.reserve(casters.size());
+  for (uint32_t slot : casters) {
+    glm::vec4 clip = lightProjView * transforms.find(meshes.ownerAt(slot))->mat4()[3];
+    float depth = clip.w > 0.f ? clip.z / clip.w : 0.f;
+    const auto& model = *meshes.at(slot).model;
+    drawList.push(
+        LveSortKey::make(0, 0, 0, model.getBindingId(), drawList.modelIndex(reinterpret_cast<uintptr_t>(&model)), LveSortKey::quantizeDepth(depth)), slot);
   }
+  drawList.sort();
+
+  VkDescriptorSet objectSet = frameInfo.frameAllocator.getDescriptorSet();
+  const uint32_t maxInstances = static_cast<uint32_t>(frameInfo.frameAllocator.getStorageRange() / sizeof(LveInstanceData));
+  ShadowPushConstantData push{};
+  push.lightProjectionView = lightProjView;
+
+  frameInfo.renderer.recordParallel(frameInfo.commandBuffer, drawList.size(), [&](LveCommandRecorder& recorder, uint32_t begin, uint32_t end) {
+    recorder.bindPipeline(*lvePipeline);
+    recorder.pushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowPushConstantData), &push);
+    const LveModel* boundModel = nullptr;
+    for (uint32_t i = begin; i < end;) {
+      const auto& mesh = meshes.at(drawList[i].payload);
+      uint32_t runEnd = i + 1;
+      while (runEnd < end && runEnd - i < maxInstances && meshes.at(drawList[runEnd].payload).model == mesh.model) runEnd++;
+
+      // same layout as the forward pass so both can read the gpu driven instance buffer, only the model matrix is read
+      auto slice = frameInfo.frameAllocator.allocate((runEnd - i) * sizeof(LveInstanceData));
+      auto* instances = static_cast<LveInstanceData*>(slice.data);
+      for (uint32_t j = i; j < runEnd; j++) instances[j - i].modelMatrix = transforms.find(meshes.ownerAt(drawList[j].payload))->mat4();
+
+      uint32_t dynamicOffsets[] = {slice.offset, slice.offset};
+      recorder.bindDescriptorSets(pipelineLayout, 0, 1, &objectSet, 2, dynamicOffsets);
+      if (!boundModel || !mesh.model->sharesBuffersWith(*boundModel)) mesh.model->bind(recorder);
+      boundModel = mesh.model.get();
+      mesh.model->draw(recorder, runEnd - i);
+      i = runEnd;
+    }
+  }, "shadow casters");
+}
+
+void ShadowSystem::renderShadowMapIndirect(FrameInfo& frameInfo, const glm::mat4& lightProjView, const LveGpuCuller& culler) {
+  const auto& batches = culler.getBatches(LveGpuCuller::SHADOW);
+  VkDescriptorSet instanceSet = culler.getInstanceSet();
+  VkBuffer commands = culler.getCommandBuffer();
+  VkBuffer counts = culler.getCountBuffer();
+  ShadowPushConstantData push{};
+  push.lightProjectionView = lightProjView;
+
+  frameInfo.renderer.recordParallel(frameInfo.commandBuffer, static_cast<uint32_t>(batches.size()), [&](LveCommandRecorder& recorder, uint32_t begin, uint32_t end) {
+    recorder.bindPipeline(*lvePipeline);
+    recorder.pushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowPushConstantData), &push);
+    uint32_t dynamicOffsets[] = {0, 0};
+    recorder.bindDescriptorSets(pipelineLayout, 0, 1, &instanceSet, 2, dynamicOffsets);
+    for (uint32_t b = begin; b < end; b++) {
+      const auto& batch = batches[b];
+      batch.model->bind(recorder);
+      recorder.drawIndexedIndirectCount(
+          commands, culler.getCommandOffset(LveGpuCuller::SHADOW, b), counts, culler.getCountOffset(LveGpuCuller::SHADOW, b), batch.maxDraws);
+    }
+  }, "shadow casters");
 }
 
 }  // namespace lve
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "core/lve_device.hpp"
+#include "renderer/lve_draw_list.hpp"
 #include "renderer/lve_frame_info.hpp"
+#include "renderer/lve_gpu_culling.hpp"
 #include "renderer/lve_pipeline.hpp"
-#include "scene/lve_game_object.hpp"
 #include "renderer/lve_shadow_map.hpp"
 
 #include <memory>
@@ -18,21 +19,29 @@ namespace lve {
 
 class ShadowSystem {
  public:
-  ShadowSystem(LveDevice &device, VkRenderPass renderPass);
+  ShadowSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout objectSetLayout);
   ~ShadowSystem();
 
   ShadowSystem(const ShadowSystem &) = delete;
   ShadowSystem &operator=(const ShadowSystem &) = delete;
 
-  void renderShadowMap(FrameInfo &frameInfo, const glm::mat4 &lightProjectionView);
+  // records the given caster mesh slots across the renderer's worker threads, one instanced draw per run of
+  // a model, front to back from the light. frameInfo.commandBuffer must be the pass primary
+  void renderShadowMap(FrameInfo &frameInfo, const glm::mat4 &lightProjectionView, const std::vector<uint32_t> &casters);
+
+  // draws what the culler's shadow view kept, one indirect count call per set of shared buffers
+  void renderShadowMapIndirect(FrameInfo &frameInfo, const glm::mat4 &lightProjectionView, const LveGpuCuller &culler);
 
  private:
-  void createPipelineLayout();
+  void createPipelineLayout(VkDescriptorSetLayout objectSetLayout);
   void createPipeline(VkRenderPass renderPass);
 
   LveDevice &lveDevice;
   std::unique_ptr<LvePipeline> lvePipeline;
   VkPipelineLayout pipelineLayout;
+
+  // reused every frame, payloads are mesh pool slots
+  LveDrawList drawList;
 };
 
 }  // namespace lve
@@ -1,5 +1,7 @@
 #include "systems/simple_render_system.hpp"
 
+#include "renderer/lve_instance_data.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -16,14 +18,8 @@
 
 namespace lve {
 
-struct SimplePushConstantData {
-  glm::mat4 modelMatrix{1.f};
-  glm::mat4 normalMatrix{1.f};
-  glm::vec2 uvScale{1.f, 1.f};
-};
-
-SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass rp, VkDescriptorSetLayout globalLayout) : lveDevice{device} {
-  createPipelineLayout(globalLayout);
+SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass rp, VkDescriptorSetLayout globalLayout, VkDescriptorSetLayout objectLayout) : lveDevice{device} {
+  createPipelineLayout(globalLayout, objectLayout);
   createPipeline(rp);
 }
 
@@ -31,22 +27,17 @@ SimpleRenderSystem::~SimpleRenderSystem() {
   vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 }
 
-void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalLayout) {
-  VkPushConstantRange pushRange{};
-  pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-  pushRange.offset = 0;
-  pushRange.size = sizeof(SimplePushConstantData);
-  
+void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalLayout, VkDescriptorSetLayout objectLayout) {
   textureSetLayout = LveDescriptorSetLayout::Builder(lveDevice).addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT).build();
   shadowSetLayout = LveDescriptorSetLayout::Builder(lveDevice).addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT).build();
 
-  std::vector<VkDescriptorSetLayout> layouts{globalLayout, textureSetLayout->getDescriptorSetLayout(), shadowSetLayout->getDescriptorSetLayout()};
+  std::vector<VkDescriptorSetLayout> layouts{globalLayout, textureSetLayout->getDescriptorSetLayout(), shadowSetLayout->getDescriptorSetLayout(), objectLayout};
   VkPipelineLayoutCreateInfo info{};
   info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   info.setLayoutCount = static_cast<uint32_t>(layouts.size());
   info.pSetLayouts = layouts.data();
-  info.pushConstantRangeCount = 1;
-  info.pPushConstantRanges = &pushRange;
+  info.pushConstantRangeCount = 0;
+  info.pPushConstantRanges = nullptr;
 
   if (vkCreatePipelineLayout(lveDevice.device(), &info, nullptr, &pipelineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline layout");
 }
@@ -60,28 +51,111 @@ void SimpleRenderSystem::createPipeline(VkRenderPass rp) {
   lvePipeline = std::make_unique<LvePipeline>(lveDevice, "shaders/simple_shader.vert.spv", "shaders/simple_shader.frag.spv", config);
 }
 
-void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo, VkDescriptorSet shadowSet) {
-  lvePipeline->bind(frameInfo.commandBuffer);
-  vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
-  vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 2, 1, &shadowSet, 0, nullptr);
-
-  for (auto& kv : frameInfo.gameObjects) {
-    auto& obj = kv.second;
-    if (!obj.model) continue;
-
-    if (obj.textureDescriptorSet != VK_NULL_HANDLE) {
-      vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &obj.textureDescriptorSet, 0, nullptr);
+void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo, VkDescriptorSet shadowSet, const std::vector<uint32_t>& visibleMeshes) {
+  // one instance per visible mesh slot, transforms and materials are looked up through the owner
+  const auto& meshes = frameInfo.scene.pool<MeshComponent>();
+  const auto& transforms = frameInfo.scene.pool<TransformComponent>();
+  const auto& materials = frameInfo.scene.pool<MaterialComponent>();
+  VkDescriptorSet objectSet = frameInfo.frameAllocator.getDescriptorSet();
+  const uint32_t maxInstances = static_cast<uint32_t>(frameInfo.frameAllocator.getStorageRange() / sizeof(LveInstanceData));
+
+  const glm::mat4 projectionView = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+  drawList.clear();
+  drawList.reserve(visibleMeshes.size());
+  for (uint32_t slot : visibleMeshes) {
+    const auto& model = *meshes.at(slot).model;
+    uint32_t owner = meshes.ownerAt(slot);
+    const auto* material = materials.find(owner);
+    glm::vec4 clip = projectionView * transforms.find(owner)->mat4()[3];
+    // an origin on or behind the camera plane has no meaningful depth, it sorts first
+    float depth = clip.w > 0.f ? clip.z / clip.w : 0.f;
+    uint64_t textures = material ? reinterpret_cast<uintptr_t>(material->textureDescriptorSet) : 0;
+    drawList.push(
+        LveSortKey::make(
+            0, 0, drawList.materialIndex(textures), model.getBindingId(), drawList.modelIndex(reinterpret_cast<uintptr_t>(&model)), LveSortKey::quantizeDepth(depth)),
+        slot);
+  }
+  drawList.sort();
+
+  // each range runs on its own secondary, so pipeline and shared sets are bound per range
+  frameInfo.renderer.recordParallel(frameInfo.commandBuffer, drawList.size(), [&](LveCommandRecorder& recorder, uint32_t begin, uint32_t end) {
+    recorder.bindPipeline(*lvePipeline);
+    recorder.bindDescriptorSets(pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet);
+    recorder.bindDescriptorSets(pipelineLayout, 2, 1, &shadowSet);
+
+    const LveModel* boundModel = nullptr;
+    VkDescriptorSet boundTextures = VK_NULL_HANDLE;
+    for (uint32_t i = begin; i < end;) {
+      const auto& mesh = meshes.at(drawList[i].payload);
+      const auto* material = materials.find(meshes.ownerAt(drawList[i].payload));
+      VkDescriptorSet textures = material ? material->textureDescriptorSet : VK_NULL_HANDLE;
+
+      // sorting put draws of the same model and textures next to each other, each run is one instanced draw
+      uint32_t runEnd = i + 1;
+      while (runEnd < end && runEnd - i < maxInstances) {
+        uint32_t slot = drawList[runEnd].payload;
+        const auto* next = materials.find(meshes.ownerAt(slot));
+        if (meshes.at(slot).model != mesh.model || (next ? next->textureDescriptorSet : VK_NULL_HANDLE) != textures) break;
+        runEnd++;
+      }
+
+      if (textures != VK_NULL_HANDLE && textures != boundTextures) {
+        recorder.bindDescriptorSets(pipelineLayout, 1, 1, &textures);
+        boundTextures = textures;
+      }
+
+      auto slice = frameInfo.frameAllocator.allocate((runEnd - i) * sizeof(LveInstanceData));
+      auto* instances = static_cast<LveInstanceData*>(slice.data);
+      for (uint32_t j = i; j < runEnd; j++) {
+        uint32_t owner = meshes.ownerAt(drawList[j].payload);
+        const auto& transform = *transforms.find(owner);
+        const auto* instanceMaterial = materials.find(owner);
+        auto& instance = instances[j - i];
+        instance = LveInstanceData{};
+        instance.modelMatrix = transform.mat4();
+        instance.normalMatrix = transform.normalMatrix();
+        if (instanceMaterial) instance.uvScale = instanceMaterial->uvScale;
+      }
+
+      // binding 0 is unused by the shader but still needs a valid dynamic offset
+      uint32_t dynamicOffsets[] = {slice.offset, slice.offset};
+      recorder.bindDescriptorSets(pipelineLayout, 3, 1, &objectSet, 2, dynamicOffsets);
+      if (!boundModel || !mesh.model->sharesBuffersWith(*boundModel)) mesh.model->bind(recorder);
+      boundModel = mesh.model.get();
+      mesh.model->draw(recorder, runEnd - i);
+      i = runEnd;
     }
+  }, "forward");
+}
 
-    SimplePushConstantData push{};
-    push.modelMatrix = obj.transform.mat4();
-    push.normalMatrix = obj.transform.normalMatrix();
-    push.uvScale = obj.uvScale;
-    
-    vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-    obj.model->bind(frameInfo.commandBuffer);
-    obj.model->draw(frameInfo.commandBuffer);
-  }
+void SimpleRenderSystem::renderIndirect(FrameInfo& frameInfo, VkDescriptorSet shadowSet, const LveGpuCuller& culler, LveGpuCuller::View view) {
+  const auto& batches = culler.getBatches(view);
+  VkDescriptorSet instanceSet = culler.getInstanceSet();
+  VkBuffer commands = culler.getCommandBuffer();
+  VkBuffer counts = culler.getCountBuffer();
+
+  // the commands index the persistent instance buffer through firstInstance, so its set needs no offsets
+  frameInfo.renderer.recordParallel(frameInfo.commandBuffer, static_cast<uint32_t>(batches.size()), [&](LveCommandRecorder& recorder, uint32_t begin, uint32_t end) {
+    recorder.bindPipeline(*lvePipeline);
+    recorder.bindDescriptorSets(pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet);
+    recorder.bindDescriptorSets(pipelineLayout, 2, 1, &shadowSet);
+    uint32_t dynamicOffsets[] = {0, 0};
+    recorder.bindDescriptorSets(pipelineLayout, 3, 1, &instanceSet, 2, dynamicOffsets);
+
+    const LveModel* boundModel = nullptr;
+    VkDescriptorSet boundTextures = VK_NULL_HANDLE;
+    for (uint32_t b = begin; b < end; b++) {
+      const auto& batch = batches[b];
+      if (batch.textures != VK_NULL_HANDLE && batch.textures != boundTextures) {
+        recorder.bindDescriptorSets(pipelineLayout, 1, 1, &batch.textures);
+        boundTextures = batch.textures;
+      }
+      if (!boundModel || !batch.model->sharesBuffersWith(*boundModel)) batch.model->bind(recorder);
+      boundModel = batch.model;
+      recorder.drawIndexedIndirectCount(
+          commands, culler.getCommandOffset(view, b), counts, culler.getCountOffset(view, b), batch.maxDraws);
+    }
+  }, "forward");
 }
 
 }  // namespace lve
@@ -3,8 +3,9 @@
 #include "core/lve_device.hpp"
 #include "renderer/lve_frame_info.hpp"
 #include "renderer/lve_pipeline.hpp"
-#include "scene/lve_game_object.hpp"
 #include "renderer/lve_descriptors.hpp"
+#include "renderer/lve_draw_list.hpp"
+#include "renderer/lve_gpu_culling.hpp"
 
 #include <memory>
 #include <vector>
@@ -18,7 +19,7 @@ namespace lve {
 
 class SimpleRenderSystem {
  public:
-  SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+  SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout objectSetLayout);
   ~SimpleRenderSystem();
 
   SimpleRenderSystem(const SimpleRenderSystem &) = delete;
@@ -27,10 +28,17 @@ class SimpleRenderSystem {
   LveDescriptorSetLayout& getTextureSetLayout() const noexcept { return *textureSetLayout; }
   LveDescriptorSetLayout& getShadowSetLayout() const noexcept { return *shadowSetLayout; }
 
-  void renderGameObjects(FrameInfo &frameInfo, VkDescriptorSet shadowDescriptorSet);
+  // records the visible mesh pool slots across the renderer's worker threads, sorted by material, mesh
+  // and depth so consecutive draws can skip binds, and with every run of one model and texture set drawn
+  // as a single instanced call. frameInfo.commandBuffer must be the pass primary
+  void renderGameObjects(FrameInfo &frameInfo, VkDescriptorSet shadowDescriptorSet, const std::vector<uint32_t> &visibleMeshes);
+
+  // draws what one of the culler's camera views kept, one indirect count call per batch. the culling
+  // that fills the view must already be recorded on the primary for this frame
+  void renderIndirect(FrameInfo &frameInfo, VkDescriptorSet shadowDescriptorSet, const LveGpuCuller &culler, LveGpuCuller::View view);
 
  private:
-  void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+  void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout objectSetLayout);
   void createPipeline(VkRenderPass renderPass);
 
   LveDevice &lveDevice;
@@ -39,6 +47,9 @@ class SimpleRenderSystem {
 
   std::unique_ptr<LveDescriptorSetLayout> textureSetLayout;
   std::unique_ptr<LveDescriptorSetLayout> shadowSetLayout;
+
+  // reused every frame, payloads are mesh pool slots
+  LveDrawList drawList;
 };
 
 }  // namespace lve
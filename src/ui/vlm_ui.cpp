@@ -4,6 +4,7 @@
 #include <stdexcept>
 #include <cstring>
 #include <cstdio>
+#include <string>
 
 /**
  * ui implementation.
@@ -85,6 +86,8 @@ VlmUi::VlmUi(LveDevice &device, VkRenderPass rp, uint32_t w, uint32_t h)
           .stat-item:last-child { margin-bottom: 0; }
           .label { font-size: 9px; font-weight: 600; color: var(--text-dim); text-transform: uppercase; letter-spacing: 0.05em; margin-bottom: 2px; }
           .value { font-size: 15px; font-weight: 700; color: var(--accent); font-family: "JetBrains Mono", monospace; }
+          .value.warn { color: #ff4d4d; }
+          .detail { font-size: 9px; color: var(--text-dim); font-family: "JetBrains Mono", monospace; margin-top: 2px; }
         </style>
       </head>
       <body>
@@ -104,6 +107,21 @@ VlmUi::VlmUi(LveDevice &device, VkRenderPass rp, uint32_t w, uint32_t h)
             <div class="label">Coordinates (XYZ)</div>
             <div class="value" id="pos_val">0.0, 0.0, 0.0</div>
           </div>
+          <div class="stat-item">
+            <div class="label">GPU Time</div>
+            <div class="value" id="gpu_val">-</div>
+            <div class="detail" id="gpu_scopes"></div>
+          </div>
+          <div class="stat-item">
+            <div class="label">Draw Calls</div>
+            <div class="value" id="draw_val">0</div>
+            <div class="detail" id="draw_stats"></div>
+          </div>
+          <div class="stat-item">
+            <div class="label">GPU Memory</div>
+            <div class="value" id="mem_val">0 / 0 MiB</div>
+            <div class="detail" id="mem_tags"></div>
+          </div>
           <div class="stat-item">
             <div class="label">Tick Count</div>
             <div class="value" id="cycle_val">0</div>
@@ -119,9 +137,21 @@ VlmUi::VlmUi(LveDevice &device, VkRenderPass rp, uint32_t w, uint32_t h)
             box.style.left = x + 'px'; box.style.top = y + 'px';
           };
           window.onmouseup = () => { isDragging = false; box.style.borderColor = 'rgba(255, 255, 255, 0.12)'; };
-          window.updateTelemetry = (fps, x, y, z) => {
+          window.updateTelemetry = (fps, x, y, z, memUsed, memBudget, memWarn, memTags) => {
             document.getElementById('fps_val').innerText = `${fps.toFixed(1)} FPS`;
             document.getElementById('pos_val').innerText = `${x.toFixed(2)}, ${y.toFixed(2)}, ${z.toFixed(2)}`;
+            const mem = document.getElementById('mem_val');
+            mem.innerText = `${memUsed.toFixed(0)} / ${memBudget.toFixed(0)} MiB` + (memWarn ? ' !' : '');
+            mem.className = memWarn ? 'value warn' : 'value';
+            document.getElementById('mem_tags').innerText = memTags;
+          };
+          window.updateGpuTimings = (frameMs, scopes) => {
+            document.getElementById('gpu_val').innerText = frameMs > 0 ? `${frameMs.toFixed(2)} ms` : '-';
+            document.getElementById('gpu_scopes').innerText = scopes;
+          };
+          window.updateRenderStats = (draws, stats) => {
+            document.getElementById('draw_val').innerText = `${draws}`;
+            document.getElementById('draw_stats').innerText = stats;
           };
           let c = 0; setInterval(() => { document.getElementById('cycle_val').innerText = c++; }, 100);
         </script>
@@ -139,10 +169,10 @@ VlmUi::VlmUi(LveDevice &device, VkRenderPass rp, uint32_t w, uint32_t h)
 }
 
 VlmUi::~VlmUi() {
+  lveDevice.uploadQueue().waitIdle();
   vkDestroySampler(lveDevice.device(), uiSampler, nullptr);
   vkDestroyImageView(lveDevice.device(), uiImageView, nullptr);
-  vkDestroyImage(lveDevice.device(), uiImage, nullptr);
-  vkFreeMemory(lveDevice.device(), uiImageMemory, nullptr);
+  lveDevice.destroyImage(uiImage, uiImageAllocation);
   vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 
   ulDestroyView(view);
@@ -161,10 +191,11 @@ void VlmUi::resize(uint32_t nw, uint32_t nh) {
   glfwGetFramebufferSize(glfwWin, &fbW, &fbH);
   ulViewSetDeviceScale(view, (double)fbW / (double)winW);
 
+  // a queued copy may still target the old image
+  lveDevice.uploadQueue().waitIdle();
   vkDestroySampler(lveDevice.device(), uiSampler, nullptr);
   vkDestroyImageView(lveDevice.device(), uiImageView, nullptr);
-  vkDestroyImage(lveDevice.device(), uiImage, nullptr);
-  vkFreeMemory(lveDevice.device(), uiImageMemory, nullptr);
+  lveDevice.destroyImage(uiImage, uiImageAllocation);
   createUiTexture();
 }
 
@@ -181,9 +212,83 @@ void VlmUi::update() {
   }
 }
 
-void VlmUi::updateTelemetry(float fps, float x, float y, float z) {
-  char cmd[256];
-  snprintf(cmd, sizeof(cmd), "updateTelemetry(%f, %f, %f, %f)", fps, x, y, z);
+void VlmUi::updateTelemetry(float fps, float x, float y, float z, const std::vector<LveHeapBudget> &budgets, const LveTagStatsArray &tags) {
+  constexpr double mib = 1024.0 * 1024.0;
+  double used = 0.0, budget = 0.0;
+  bool warn = false;
+  for (const auto &heap : budgets) {
+    if (!(heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+    used += heap.usage / mib;
+    budget += heap.budget / mib;
+    warn = warn || heap.isNearBudget();
+  }
+
+  std::string breakdown;
+  for (size_t i = 0; i < tags.size(); i++) {
+    if (tags[i].allocationCount == 0) continue;
+    char entry[48];
+    snprintf(entry, sizeof(entry), "%s%s %.1f", breakdown.empty() ? "" : " / ", memoryTagName(static_cast<LveMemoryTag>(i)), tags[i].bytes / mib);
+    breakdown += entry;
+  }
+
+  char cmd[1024];
+  snprintf(cmd, sizeof(cmd), "updateTelemetry(%f, %f, %f, %f, %f, %f, %s, '%s')", fps, x, y, z, used, budget, warn ? "true" : "false", breakdown.c_str());
+  ULString script = ulCreateString(cmd);
+  ulViewEvaluateScript(view, script, nullptr);
+  ulDestroyString(script);
+}
+
+void VlmUi::updateGpuTimings(const std::vector<LveGpuProfiler::ScopeStats> &scopes) {
+  float frameMs = 0.f;
+  std::string lines;
+  for (const auto &scope : scopes) {
+    if (scope.name == "frame") {
+      frameMs = scope.averageMs;
+      continue;
+    }
+    char entry[64];
+    snprintf(entry, sizeof(entry), "%s%s %.2f ms", lines.empty() ? "" : "\\n", scope.name.c_str(), scope.averageMs);
+    lines += entry;
+  }
+
+  char cmd[1024];
+  snprintf(cmd, sizeof(cmd), "updateGpuTimings(%f, '%s')", frameMs, lines.c_str());
+  ULString script = ulCreateString(cmd);
+  ulViewEvaluateScript(view, script, nullptr);
+  ulDestroyString(script);
+}
+
+void VlmUi::updateRenderStats(const LveDrawCounters &counters, const std::vector<LveRenderStats::PassStatistics> &passes, const LveCullStats &culling,
+    const LveCullStats &shadowCulling) {
+  char lines[768];
+  int length = snprintf(
+      lines,
+      sizeof(lines),
+      "%.1fk tris\\n%u pipelines / %u sets / %u buffers\\n%.1f KiB push constants\\n%u visible / %u culled / %u occluded\\n%u casters / %u rejected",
+      counters.triangles / 1000.0,
+      counters.pipelineBinds,
+      counters.descriptorSetBinds,
+      counters.bufferBinds,
+      counters.pushConstantBytes / 1024.0,
+      culling.visible,
+      culling.culled,
+      culling.occluded,
+      shadowCulling.visible,
+      shadowCulling.culled);
+  for (const auto &pass : passes) {
+    if (length < 0 || length >= static_cast<int>(sizeof(lines))) break;
+    length += snprintf(
+        lines + length,
+        sizeof(lines) - length,
+        "\\n%s: %.1fk vs / %.1fk prims / %.1fk fs",
+        pass.name.c_str(),
+        pass.vertexInvocations / 1000.0,
+        pass.clippingPrimitives / 1000.0,
+        pass.fragmentInvocations / 1000.0);
+  }
+
+  char cmd[1024];
+  snprintf(cmd, sizeof(cmd), "updateRenderStats(%u, '%s')", counters.drawCalls, lines);
   ULString script = ulCreateString(cmd);
   ulViewEvaluateScript(view, script, nullptr);
   ulDestroyString(script);
@@ -209,7 +314,7 @@ void VlmUi::createUiTexture() {
   info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   
-  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, uiImage, uiImageMemory);
+  lveDevice.createImageWithInfo(info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, uiImage, uiImageAllocation, LveMemoryTag::Ui);
 
   auto cmd = lveDevice.beginSingleTimeCommands();
   VkImageMemoryBarrier barrier{};
@@ -265,42 +370,14 @@ void VlmUi::createUiTexture() {
   VkDescriptorImageInfo imageInfo{uiSampler, uiImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
   LveDescriptorWriter(*descriptorSetLayout, *descriptorPool).writeImage(0, &imageInfo).build(descriptorSet);
 
-  stagingBuffer = std::make_unique<LveBuffer>(lveDevice, 4, width * height, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-  stagingBuffer->map();
 }
 
 void VlmUi::updateUiTexture() {
   ULSurface surf = ulViewGetSurface(view);
   ULBitmap bmp = ulBitmapSurfaceGetBitmap(surf);
   void* px = ulBitmapLockPixels(bmp);
-  stagingBuffer->writeToBuffer(px);
+  lveDevice.uploadQueue().enqueueImageUpload(uiImage, px, static_cast<VkDeviceSize>(width) * height * 4, width, height, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
   ulBitmapUnlockPixels(bmp);
-
-  auto cmd = lveDevice.beginSingleTimeCommands();
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image = uiImage;
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-  barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  
-  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-  lveDevice.copyBufferToImage(stagingBuffer->getBuffer(), uiImage, width, height, 1);
-  
-  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-  lveDevice.endSingleTimeCommands(cmd);
 }
 
 void VlmUi::createPipeline(VkRenderPass rp) {
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "core/lve_device.hpp"
-#include "renderer/lve_buffer.hpp"
 #include "renderer/lve_descriptors.hpp"
+#include "renderer/lve_gpu_profiler.hpp"
+#include "renderer/lve_render_stats.hpp"
 #include "renderer/lve_pipeline.hpp"
+#include "scene/lve_culling.hpp"
 
 #include <AppCore/CAPI.h>
 
@@ -31,7 +33,13 @@ class VlmUi {
   
   void handleMouseMove(double x, double y);
   void handleMouseButton(int button, int action, int mods);
-  void updateTelemetry(float fps, float x, float y, float z);
+  // memory shows the device local heaps against their budget plus the per-tag breakdown
+  void updateTelemetry(float fps, float x, float y, float z, const std::vector<LveHeapBudget> &budgets, const LveTagStatsArray &tags);
+  // rolling gpu time per profiler scope, the "frame" scope is shown as the headline number
+  void updateGpuTimings(const std::vector<LveGpuProfiler::ScopeStats> &scopes);
+  // last frame's draw counters, camera and shadow caster culling, plus pipeline statistics per pass when the device supports them
+  void updateRenderStats(const LveDrawCounters &counters, const std::vector<LveRenderStats::PassStatistics> &passes, const LveCullStats &culling,
+      const LveCullStats &shadowCulling);
 
   void resize(uint32_t width, uint32_t height);
 
@@ -50,14 +58,13 @@ class VlmUi {
   ULConfig config;
 
   VkImage uiImage = VK_NULL_HANDLE;
-  VkDeviceMemory uiImageMemory = VK_NULL_HANDLE;
+  LveAllocation uiImageAllocation{};
   VkImageView uiImageView = VK_NULL_HANDLE;
   VkSampler uiSampler = VK_NULL_HANDLE;
   VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
   
   std::unique_ptr<LveDescriptorSetLayout> descriptorSetLayout;
   std::unique_ptr<LveDescriptorPool> descriptorPool;
-  std::unique_ptr<LveBuffer> stagingBuffer;
 
   VkPipelineLayout pipelineLayout;
   std::unique_ptr<LvePipeline> lvePipeline;